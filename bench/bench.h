@@ -0,0 +1,20 @@
+/** @file bench.h
+ * What the benchmarks share, along with the tests' helpers
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <curses.h>
+#include <stdio.h>
+#include <time.h>
+#include "../test/test.h"
+
+/// Seconds on a monotonic clock, for timing
+static inline double Seconds () {
+	struct timespec now;
+	clock_gettime (CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+#endif
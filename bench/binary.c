@@ -0,0 +1,70 @@
+/** @file binary.c
+ * Saves and loads an image as a binary .mosb file and as a text .mosi
+ * one, timing both and comparing the files' sizes
+ *
+ * Usage: bench_binary [HEIGHT WIDTH]; 1000 x 1000 by default
+ */
+
+#include "maae.h"
+#include "binary.h"
+#include "bench.h"
+
+#include <mosaic/stream_io.h>
+#include <sys/stat.h>
+#include <stdlib.h>
+
+/// How many times each file is saved and loaded; the best time counts
+#define TRIES 3
+
+/// Aux function: times saving img in file_name, and loading it back
+static void Time (MOSAIC *img, const char *file_name, char binary) {
+	MOSAIC *back = NewMOSAIC (0, 0);
+	double save = 0, load = 0;
+	int i;
+	for (i = 0; i < TRIES; i++) {
+		double start = Seconds ();
+		const int saved = binary ? SaveBinary (img, file_name, NULL)
+				: SaveMOSAIC (img, file_name);
+		const double saving = Seconds () - start;
+		start = Seconds ();
+		const int loaded = binary ? LoadBinary (back, file_name)
+				: LoadMOSAIC (back, file_name);
+		const double loading = Seconds () - start;
+		if (saved || loaded) {
+			fprintf (stderr, "%s: save %d, load %d\n", file_name, saved, loaded);
+			exit (1);
+		}
+		save = i == 0 || saving < save ? saving : save;
+		load = i == 0 || loading < load ? loading : load;
+	}
+
+	struct stat info;
+	stat (file_name, &info);
+	printf ("%s: %.1f MB, save %.1f ms, load %.1f ms\n", file_name,
+			info.st_size / 1e6, save * 1e3, load * 1e3);
+	remove (file_name);
+	FreeMOSAIC (back);
+}
+
+
+int main (int argc, char *argv[]) {
+	const int height = argc > 2 ? atoi (argv[1]) : 1000;
+	const int width = argc > 2 ? atoi (argv[2]) : 1000;
+	MOSAIC *img = NewMOSAIC (height, width);
+	// words and blanks, in a few colors: runs and literals
+	int y, x;
+	for (y = 0; y < height; y++) {
+		for (x = 0; x < width; x++) {
+			const int i = MOS_INDEX (img, y, x);
+			img->mosaic[i] = (x + y) % 12 < 7 ? 'a' + (x * 7 + y) % 26 : ' ';
+			img->attr[i] = (x / 16 + y / 8) % 9;
+		}
+	}
+
+	printf ("%dx%d\n", height, width);
+	Time (img, "bench_binary" BINARY_EXTENSION, 1);
+	Time (img, "bench_binary.mosi", 0);
+
+	FreeMOSAIC (img);
+	return 0;
+}
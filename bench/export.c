@@ -0,0 +1,73 @@
+/** @file export.c
+ * Exports images as ANSI text, timing it and counting the bytes written:
+ * a flat one (a single attribute run per line), one with runs of 8 cells
+ * and one with a new attribute every cell, the worst case
+ *
+ * Usage: bench_export [HEIGHT WIDTH]; 2000 x 2000 by default
+ */
+
+#include "maae.h"
+#include "export.h"
+#include "bench.h"
+
+#include <stdlib.h>
+
+/// How many times each image is exported; the best time counts
+#define TRIES 5
+
+/// Aux function: exports img to out TRIES times, giving the best time
+static double Export (MOSAIC *img, FILE *out, long *bytes) {
+	double best = 0;
+	int i;
+	for (i = 0; i < TRIES; i++) {
+		rewind (out);
+		const double start = Seconds ();
+		if (ExportANSI (img, out)) {
+			perror ("ExportANSI");
+			exit (1);
+		}
+		const double took = Seconds () - start;
+		best = i == 0 || took < best ? took : best;
+	}
+	*bytes = ftell (out);
+	return best;
+}
+
+
+int main (int argc, char *argv[]) {
+	const int height = argc > 2 ? atoi (argv[1]) : 2000;
+	const int width = argc > 2 ? atoi (argv[2]) : 2000;
+	const char *names[] = {"flat", "runs of 8", "every cell"};
+	const int runs[] = {width, 8, 1};
+	MOSAIC *img = NewMOSAIC (height, width);
+	FILE *out = tmpfile ();
+	if (!out) {
+		perror ("tmpfile");
+		return 1;
+	}
+
+	const double megacells = (double) height * width / 1e6;
+	printf ("%dx%d, %.1f megacells\n", height, width, megacells);
+	int k, y, x;
+	for (k = 0; k < 3; k++) {
+		for (y = 0; y < height; y++) {
+			for (x = 0; x < width; x++) {
+				const int i = MOS_INDEX (img, y, x);
+				img->mosaic[i] = 'a' + (x + y) % 26;
+				// fore and back colors in 1..8, bold sometimes
+				const int run = (x / runs[k] + y) % 64;
+				img->attr[i] = ((run % 8 + 1) * COLORS_STEP + run / 8 + 1)
+						| (run % 3 ? 0 : BOLD);
+			}
+		}
+		long bytes;
+		const double took = Export (img, out, &bytes);
+		printf ("%-10s: %.1f MB, %.1f bytes per cell, %.1f ms per megacell"
+				" (%.0f MB/s)\n", names[k], bytes / 1e6, bytes / (megacells * 1e6),
+				took * 1e3 / megacells, bytes / took / 1e6);
+	}
+
+	fclose (out);
+	FreeMOSAIC (img);
+	return 0;
+}
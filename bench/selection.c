@@ -0,0 +1,66 @@
+/** @file selection.c
+ * Drags a selection across a big image, timing each step: the box as
+ * PrintSelection keeps it (only what entered or left it), against
+ * rewriting the whole pad and reversing the whole box
+ *
+ * Usage: bench_selection [HEIGHT WIDTH]; 400 x 900 by default
+ */
+
+#include "maae.h"
+#include "bench.h"
+
+#include <stdlib.h>
+
+int main (int argc, char *argv[]) {
+	const int height = argc > 2 ? atoi (argv[1]) : 400;
+	const int width = argc > 2 ? atoi (argv[2]) : 900;
+	QuietCurses ();
+	CURS_MOS *img = NewCURS_MOS (height, width);
+	int i;
+	for (i = 0; i < height * width; i++) {
+		img->img->mosaic[i] = 'a' + i % 26;
+		img->img->attr[i] = i % 8;
+	}
+	RewriteCURS_MOS (img);
+
+	// from the upper-left corner to the bottom-right one, a cell at a time
+	Cursor cursor;
+	InitCursor (&cursor);
+	const int steps = height + width - 2;
+	double start = Seconds ();
+	for (i = 0; i < steps; i++) {
+		if ((i % 2 && cursor.y < height - 1) || cursor.x == width - 1) {
+			cursor.y++;
+		}
+		else {
+			cursor.x++;
+		}
+		PrintSelection (&cursor, img);
+	}
+	const double incremental = (Seconds () - start) / steps;
+	UnprintSelection (img);
+
+	InitCursor (&cursor);
+	start = Seconds ();
+	for (i = 0; i < steps; i++) {
+		if ((i % 2 && cursor.y < height - 1) || cursor.x == width - 1) {
+			cursor.y++;
+		}
+		else {
+			cursor.x++;
+		}
+		RewriteCURS_MOS (img);
+		int y;
+		for (y = 0; y <= cursor.y; y++) {
+			mvwchgat (img->win, y, 0, cursor.x + 1, A_REVERSE, Normal, NULL);
+		}
+		DisplayCurrentMOSAIC (img);
+	}
+	const double whole = (Seconds () - start) / steps;
+	endwin ();
+
+	printf ("%dx%d, %d steps: %.1f us per step (whole pad: %.1f us, %.0fx)\n",
+			height, width, steps, incremental * 1e6, whole * 1e6,
+			whole / incremental);
+	return 0;
+}
@@ -5,14 +5,37 @@
 #define ARGPSTUFF_H
 
 #include "state.h"
+#include "blit.h"
+#include "batch.h"
+
+/// The parsed command line options
+struct arguments {
+	char *input;	///< the optional filename, for opening maae loading a file
+	char **inputs;	///< every file given (batch mode takes many)
+	int n_inputs;	///< how many files were given
+	BatchTarget batch;	///< batch conversion target; BATCH_NONE for no batch
+	char *output_dir;	///< where batch outputs go; NULL for next to the inputs
+	int jobs;	///< batch workers; 0 for one per CPU
+	char dimensions;	///< print the image dimensions, headless
+	char color;	///< print the image as ANSI text, headless
+	int max_fps;	///< maximum screen updates per second (0: no limit)
+	BlitKey transparent_key;	///< which cells are skipped by transparent pasting
+	int history_kb;	///< memory cap for undo/redo, in KB
+	int scroll_margin;	///< cells kept between the cursor and the view's borders
+	int autosave;	///< seconds between autosaves (0: none)
+	int journal_kb;	///< journal size limit for saves, in KB (0: no journal)
+	int play_fps;	///< playback speed, in frames per second
+};
 
 /**
  * Parse command line options
  *
  * Ask the parser for the options, and enable them in the state
  *
- * @return the optional filename, for opening maae loading a file
+ * @param[in] argc Main's argc
+ * @param[in] argv Main's argv
+ * @param[out] args The parsed options, defaults for those not given
  */
-const char *arguments (int argc, char *argv[]);
+void arguments (int argc, char *argv[], struct arguments *args);
 
 #endif
@@ -0,0 +1,74 @@
+/** @file async.h
+ * Background file I/O: loads and saves run in a worker thread, so the
+ * editor stays live while they go
+ *
+ * A save works on a snapshot taken when it starts, so edits made
+ * meanwhile don't get into the file. A load reads into an image of its
+ * own, that replaces the target's contents only when finished. There's
+ * a single job at a time.
+ */
+
+#ifndef ASYNC_H
+#define ASYNC_H
+
+#include <mosaic/cursmos.h>
+
+/// How often to look at a running job, for the progress, in milliseconds
+#define ASYNC_POLL_MS 100
+
+/// The kind of job
+typedef enum {
+	ASYNC_IDLE = 0,	///< no job
+	ASYNC_SAVE,	///< saving a file
+	ASYNC_LOAD	///< loading a file
+} AsyncKind;
+
+/**
+ * Starts saving img in the background, snapshotting it first
+ *
+ * @param[in] img The image
+ * @param[in] file_name The file; binary if BinaryName
+ *
+ * @return 0 if started, EBUSY if there's a job running already
+ */
+int StartSave (CURS_MOS *img, const char *file_name);
+/**
+ * Starts loading a file in img, in the background
+ *
+ * @param[in] img The image that will get the file's contents
+ * @param[in] file_name The file, text or binary
+ *
+ * @return 0 if started, EBUSY if there's a job running already
+ */
+int StartLoad (CURS_MOS *img, const char *file_name);
+/**
+ * The running (or finished, but not yet collected) job's kind
+ */
+AsyncKind AsyncRunning ();
+/**
+ * How much of the running job is done
+ *
+ * @return A percentage, or -1 if it can't be known
+ */
+int AsyncProgress ();
+/**
+ * The running job's file name
+ */
+const char *AsyncFile ();
+/**
+ * Collects the job, if it's finished, putting loaded files in their
+ * target image
+ *
+ * @param[out] kind The job's kind
+ * @param[out] target The image the job was about
+ *
+ * @return ERR if there's no finished job, or the job's return value:
+ * LoadMOSAIC's, SaveMOSAIC's or the binary files' ones
+ */
+int FinishAsync (AsyncKind *kind, CURS_MOS **target);
+/**
+ * Waits until the running job finishes; FinishAsync still collects it
+ */
+void WaitAsync ();
+
+#endif
@@ -0,0 +1,74 @@
+/** @file autosave.h
+ * Crash recovery: every image is saved now and then to a recovery
+ * directory, and a later session offers to bring them back
+ *
+ * The saving is done by a forked child, so the snapshot is the kernel's
+ * copy-on-write of the whole process: taking it costs only the page
+ * tables, whatever the size of the images, and the editor goes on while
+ * the child writes. Each file is written aside and renamed in place, so
+ * a crash while saving leaves the previous one whole.
+ *
+ * Files are named "PID-N.mosb", PID being the session's and N the
+ * image's position in the IMGS; a clean exit removes them. While it runs,
+ * the session holds a lock (flock) on "PID.lock": files whose lock isn't
+ * held are from a crashed session, even if another process has the PID.
+ */
+
+#ifndef AUTOSAVE_H
+#define AUTOSAVE_H
+
+#include <mosaic/cursmos.h>
+
+/// Default time between autosaves, in seconds
+#define DEFAULT_AUTOSAVE_INTERVAL 60
+
+/**
+ * Sets the time between autosaves
+ *
+ * @param[in] seconds The interval; 0 disables autosaving
+ */
+void SetAutosaveInterval (int seconds);
+/**
+ * How long until the next autosave is due
+ *
+ * @return Milliseconds to wait, or -1 if there's nothing to save
+ */
+int AutosaveWait ();
+/**
+ * Starts an autosave, if it's due and there were changes since the last
+ * one, and collects the last one if it's done
+ *
+ * @note While a file is loaded or saved in the background (AsyncRunning),
+ * autosaves are put off, as forking with another thread running isn't
+ * safe: the next call after it's done starts it
+ *
+ * @param[in] everyone The images
+ *
+ * @return ERR if no autosave finished, or else 0 if it went alright
+ */
+int Autosave (IMGS *everyone);
+/**
+ * Stops autosaving, removing this session's files and lock (and those
+ * recovered from older ones), as everything is either saved or given up
+ */
+void EndAutosave ();
+/**
+ * Loads the images left by sessions that crashed, appending them to the
+ * IMGS, after current
+ *
+ * @param[in,out] everyone The images
+ * @param[in] current The current image, NULL if there's none yet
+ *
+ * @return The first image recovered, or NULL if none was
+ */
+CURS_MOS *RecoverImages (IMGS *everyone, CURS_MOS *current);
+/**
+ * How many images crashed sessions left to recover
+ */
+int RecoverableImages ();
+/**
+ * Removes the files crashed sessions left, not recovering them
+ */
+void DiscardRecovery ();
+
+#endif
@@ -0,0 +1,48 @@
+/** @file batch.h
+ * Batch conversion: many files at once, in parallel, without curses
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+/// What the batch converts the files to
+typedef enum {
+	BATCH_NONE = 0,	///< not in batch mode
+	BATCH_ANSI,	///< ANSI colored text (.ans)
+	BATCH_TEXT,	///< plain text (.txt)
+	BATCH_MOSI,	///< .mosi, trimmed (and resized to the trim)
+	BATCH_MOSB	///< binary .mosb, untouched
+} BatchTarget;
+
+/**
+ * Gets the target named name
+ *
+ * @param[in] name "ansi", "text", "mosi" or "mosb"
+ *
+ * @return The target, or BATCH_NONE if there's none with that name
+ */
+BatchTarget BatchTargetNamed (const char *name);
+/**
+ * Converts every input, with a pool of worker threads
+ *
+ * Directories are expanded to the .mosi and .mosb files in them, sorted by
+ * name.
+ * Each output has the input's name, with the target's extension, and goes
+ * to output_dir, or to the input's directory if it's NULL (so .mosi
+ * targets are trimmed in place).
+ *
+ * A report line per file is written to stderr, in the inputs' order,
+ * whatever order the workers finished in.
+ *
+ * @param[in] target The target format
+ * @param[in] inputs The files and directories
+ * @param[in] n_inputs How many inputs there are
+ * @param[in] output_dir Where the outputs go; NULL for next to the inputs
+ * @param[in] jobs How many workers; 0 for one per online CPU
+ *
+ * @return The exit status: 0 if every file was converted, 1 otherwise
+ */
+int Batch (BatchTarget target, char **inputs, int n_inputs,
+		const char *output_dir, int jobs);
+
+#endif
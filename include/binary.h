@@ -0,0 +1,146 @@
+/** @file binary.h
+ * Binary .mosb files: the text .mosi's fast, run-length encoded sibling
+ *
+ * Layout, integers little-endian:
+ *
+ * | bytes           | what                                               |
+ * |-----------------|----------------------------------------------------|
+ * | 4               | "MOSB"                                             |
+ * | 1               | format version (BINARY_VERSION)                    |
+ * | 1               | bytes per char in the file (1)                     |
+ * | 1               | bytes per attribute in the file (4)                |
+ * | 1               | reserved, 0                                        |
+ * | 4 + 4           | height, width                                      |
+ * | 8 * (height+1)  | offset of each row's data, and of the data's end   |
+ * | ...             | rows: PackBits encoded chars, then attributes      |
+ *
+ * In PackBits, a control byte c < 128 is followed by c + 1 literal values,
+ * and c > 128 by a single value repeated 257 - c times.
+ *
+ * The row index lets a row be decoded without touching the others, and a
+ * file is loaded with a single mmap.
+ */
+
+#ifndef BINARY_H
+#define BINARY_H
+
+#include <mosaic/mosaic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// The binary files' extension
+#define BINARY_EXTENSION ".mosb"
+/// The binary format version we write (and read)
+#define BINARY_VERSION 1
+
+/// Did a load returning ret get the image? The attributes may be missing
+/// (EUNKNSTRGFMT, worth a warning), but the chars are there all the same
+#define LoadedChars(ret) ((ret) == 0 || (ret) == EUNKNSTRGFMT)
+
+/// An open binary file, mapped in memory
+typedef struct {
+	int height;	///< image height
+	int width;	///< image width
+	const unsigned char *data;	///< the whole file
+	size_t size;	///< the file's size
+} BinaryFile;
+
+/// Fills a row's chars and attributes, for SaveBinaryRows
+typedef void (*RowSource) (void *data, int y, mos_char *chars, mos_attr *attrs);
+
+/**
+ * PackBits encodes n values, each written in size bytes (little-endian),
+ * as in the rows of binary files
+ *
+ * @param[in] vals The values
+ * @param[in] n How many values there are
+ * @param[in] size Bytes per value, in the output
+ * @param[out] out The encoded data; must fit n * (size + 1) bytes
+ *
+ * @return The encoded length
+ */
+size_t PackValues (const uint32_t *vals, int n, int size, unsigned char *out);
+/**
+ * Decodes n PackBits encoded values (PackValues' inverse), from at most
+ * len bytes
+ *
+ * @return The bytes consumed, or 0 if the data is corrupted
+ */
+size_t UnpackValues (const unsigned char *in, size_t len, int n, int size,
+		uint32_t *vals);
+/**
+ * Is the file a binary one? (looks at it's contents, not the name)
+ */
+int IsBinary (const char *file_name);
+/**
+ * Should a file with this name be saved binary? (ends with BINARY_EXTENSION)
+ */
+int BinaryName (const char *file_name);
+/**
+ * Opens a binary file, mapping it and validating the header and index
+ *
+ * @return 0 on success, the errno of a failed open/mmap, ENODIMENSIONS if
+ * it's not a binary file or EBADMSG if it's corrupted, or a side is bigger
+ * than MAX_CANVAS_SIDE
+ */
+int OpenBinary (BinaryFile *file, const char *file_name);
+/**
+ * Decodes a row of an open binary file
+ *
+ * @param[in] file The file
+ * @param[in] y The row
+ * @param[out] chars width chars
+ * @param[out] attrs width attributes
+ *
+ * @return 0 on success, EBADMSG if the row is corrupted, ENOMEM if
+ * there's no memory to decode it
+ */
+int ReadBinaryRow (BinaryFile *file, int y, mos_char *chars, mos_attr *attrs);
+/**
+ * Unmaps a binary file
+ */
+void CloseBinary (BinaryFile *file);
+/**
+ * Loads a binary file in img, that takes it's dimensions
+ *
+ * @return OpenBinary's or ReadBinaryRow's errors, 0 on success
+ */
+int LoadBinary (MOSAIC *img, const char *file_name);
+/**
+ * Loads a file in img, binary or text (LoadMOSAIC), by it's contents,
+ * replaying it's journal (ReplayJournal) if it has one
+ */
+int LoadAnyMOSAIC (MOSAIC *img, const char *file_name);
+/**
+ * Saves img as a binary file
+ *
+ * @param[in] img The image
+ * @param[in] file_name The file
+ * @param[out] rows_done Rows written so far, as SaveBinaryRows'
+ *
+ * @return 0 on success, or the errno of the failed write
+ */
+int SaveBinary (MOSAIC *img, const char *file_name, int *rows_done);
+/**
+ * Saves an image a row at a time as a binary file, so it never has to be
+ * whole in memory
+ *
+ * The file is written under another name and renamed over file_name when
+ * complete, so a mapping of the old file (OpenBinary) stays valid, and
+ * source may read from it.
+ *
+ * @param[in] height Image height
+ * @param[in] width Image width
+ * @param[in] source Called for each row, in order
+ * @param[in] data Passed to source
+ * @param[in] file_name The file
+ * @param[out] rows_done Updated with the rows written so far, so another
+ * thread can show the progress; may be NULL
+ *
+ * @return 0 on success, ENOMEM if there's no memory for a row, or the
+ * errno of the failed write
+ */
+int SaveBinaryRows (int height, int width, RowSource source, void *data,
+		const char *file_name, int *rows_done);
+
+#endif
@@ -0,0 +1,56 @@
+/** @file blit.h
+ * Block transfers of cells into a MOSAIC, opaque or with a transparent key
+ */
+
+#ifndef BLIT_H
+#define BLIT_H
+
+#include <mosaic/mosaic.h>
+#include "dirty.h"
+
+/// How Blit treats the source cells
+typedef enum {
+	BLIT_OPAQUE,	///< every cell is copied
+	BLIT_KEY_CH,	///< cells with the key char are transparent
+	BLIT_KEY_ATTR,	///< cells with the key attribute are transparent
+	BLIT_KEY_CELL	///< cells with both the key char and attribute are transparent
+} BlitMode;
+
+/// The transparency key for Blit
+typedef struct {
+	BlitMode mode;	///< which cells are transparent
+	mos_char ch;	///< the transparent char, for BLIT_KEY_CH and BLIT_KEY_CELL
+	mos_attr attr;	///< the transparent attribute, for BLIT_KEY_ATTR and BLIT_KEY_CELL
+} BlitKey;
+
+/// A block of cells to be blitted: row-major arrays, rows stride cells apart
+typedef struct {
+	const mos_char *chars;	///< the source chars
+	const mos_attr *attrs;	///< the source attributes
+	int height;	///< how many rows
+	int width;	///< how many columns
+	int stride;	///< distance between rows, in cells (width, if packed)
+} BlitSource;
+
+/**
+ * Blits a block of cells into img, with it's upper-left corner at y/x
+ *
+ * The source is clipped against img once, up front, and the kernel for the
+ * key's mode is chosen once too. Keyed kernels are branchless: they build
+ * a mask per cell and blend source and destination with it, row span
+ * by row span.
+ *
+ * @note This writes only the MOSAIC storage: mark the returned rectangle
+ * dirty afterwards
+ *
+ * @param[in,out] img The target MOSAIC
+ * @param[in] y Y coordinate for the source's upper-left corner (may be negative)
+ * @param[in] x X coordinate for the source's upper-left corner (may be negative)
+ * @param[in] src The source cells
+ * @param[in] key The transparency key
+ *
+ * @return The rectangle written in img; empty (ULy > BRy) if none
+ */
+Rect Blit (MOSAIC *img, int y, int x, BlitSource src, BlitKey key);
+
+#endif
@@ -0,0 +1,262 @@
+/** @file canvas.h
+ * Canvases: images far bigger than the screen, kept in sparse tiles
+ *
+ * A canvas is edited through a screen-sized CURS_MOS, the view, that
+ * shows part of a TileMap. Everything that edits a CURS_MOS works in the
+ * view, in its coordinates; when the view scrolls, the view and it's pad
+ * are scrolled along, and only the edges that leave or come are stored
+ * in the tiles or materialized from them.
+ *
+ * Canvases loaded from binary files are decoded lazily: the file stays
+ * mapped, and each band of TILE_SIZE rows is decoded into the tiles only
+ * when the view first reaches it, so untouched parts cost no memory.
+ *
+ * Ordinary images become canvases to be duplicated, sharing the tiles
+ * copy-on-write. Their view is the whole image, so they're edited (and
+ * edited in ranges) like they were before; but while they're not shown,
+ * the view is stowed in the tiles (StowCanvases), and they cost only the
+ * tiles they don't share.
+ */
+
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include <mosaic/cursmos.h>
+#include <sys/types.h>
+#include "tiles.h"
+#include "binary.h"
+#include "dirty.h"
+
+/// Images with a side bigger than this are created as canvases
+#define MAX_DENSE_SIDE 999
+/// Biggest side a canvas may have
+#define MAX_CANVAS_SIDE 99999
+
+/// A mapped binary file canvases decode from, shared with their snapshots
+typedef struct {
+	BinaryFile file;	///< the file
+	int refs;	///< how many canvases use it
+} CanvasSource;
+
+/// A canvas: the tiles and the view on them
+typedef struct canvas {
+	CURS_MOS *view;	///< the CURS_MOS being edited, at most screen-sized;
+	                ///< NULL in snapshots
+	TileMap *tiles;	///< the whole image
+	int y;	///< view's upper-left corner Y coordinate, in the canvas
+	int x;	///< view's upper-left corner X coordinate, in the canvas
+	CanvasSource *source;	///< file with the bands not decoded yet, or NULL
+	char *decoded;	///< for each band of TILE_SIZE rows, is it in the tiles
+	int undecoded;	///< how many bands are still only in the source
+	int corrupted;	///< rows of the source found corrupted, left blank
+	int reported;	///< how many of them were reported (NewCorruptedRows)
+	dev_t origin_dev;	///< device of the file the source came from
+	ino_t origin_ino;	///< inode of the file the source came from
+	char whole;	///< made from an ordinary image: the view is the whole
+	           ///< image, while it's not bigger than MAX_DENSE_SIDE
+	char stowed;	///< is the view stowed in the tiles, and 1x1?
+	struct canvas *next;	///< next canvas
+} Canvas;
+
+/**
+ * Creates a new blank canvas, and it's view
+ *
+ * @param[in] height Canvas height
+ * @param[in] width Canvas width
+ *
+ * @return The view, to be linked in the IMGS as any CURS_MOS
+ */
+CURS_MOS *NewCanvas (int height, int width);
+/**
+ * Creates a copy of a canvas, with the view on the same place
+ *
+ * The copy shares the tiles copy-on-write (see CopyTileMap), so it costs
+ * a pointer per tile, and memory grows only with what's edited after.
+ * Ordinary images are duplicated by making them canvases (MakeCanvas)
+ * first.
+ *
+ * @return The copy's view
+ */
+CURS_MOS *DuplicateCanvas (Canvas *canvas);
+/**
+ * Gets the canvas img is the view of
+ *
+ * @return The Canvas, or NULL if img is an ordinary image
+ */
+Canvas *GetCanvas (CURS_MOS *img);
+/**
+ * The whole image's bounds, in img's coordinates
+ *
+ * For ordinary images, that's img itself; for canvases, it goes
+ * beyond the view
+ *
+ * @param[in] img The image
+ * @param[out] bounds The image's bounds
+ */
+void CanvasBounds (CURS_MOS *img, Rect *bounds);
+/**
+ * Moves the canvas' view, so that it's upper-left corner is at y/x
+ *
+ * What the old and new places share is scrolled in the view and it's pad;
+ * only the rest is stored in the tiles, and read from them. Views moving
+ * farther than their size are stored and read whole.
+ *
+ * @note y/x are clamped so that the view stays inside the canvas
+ */
+void ShowCanvasAt (Canvas *canvas, int y, int x);
+/**
+ * Makes the canvas' view follow the cursor, scrolling like the pads do
+ *
+ * @param[in] img The image; nothing happens if it isn't a canvas
+ * @param[in,out] y Cursor Y coordinate, in the view; updated to the new one
+ * @param[in,out] x Cursor X coordinate, in the view; updated to the new one
+ *
+ * @return 1 if the view moved, 0 otherwise
+ */
+char FollowCanvas (CURS_MOS *img, int *y, int *x);
+/**
+ * Gets the canvas img is the view of, turning img into one if it isn't
+ *
+ * @note Images turned into canvases keep their view as big as them (see
+ * Canvas.whole)
+ *
+ * @return The Canvas
+ */
+Canvas *MakeCanvas (CURS_MOS *img);
+/**
+ * Resizes an image into a canvas, turning it into one if it isn't yet
+ *
+ * The canvas as it was is recorded (RecordCanvas), so the resize is undone
+ * as any other step.
+ */
+void ResizeCanvas (CURS_MOS *img, int height, int width);
+/**
+ * Copies a cells-sized region of the canvas, at y/x, into cells
+ *
+ * @note The view is stored in the tiles first, so it's edits are in
+ */
+void ReadCanvasCells (Canvas *canvas, MOSAIC *cells, int y, int x);
+/**
+ * Writes cells in the canvas, at y/x (ReadCanvasCells' inverse)
+ *
+ * @note The view is read again, if the cells reach it
+ */
+void WriteCanvasCells (Canvas *canvas, MOSAIC *cells, int y, int x);
+/**
+ * Saves the whole canvas; binary files (BinaryName) are written a band of
+ * rows at a time
+ *
+ * @param[in] canvas The canvas, or a snapshot of it
+ * @param[in] file_name The file
+ * @param[out] rows_done Rows written so far, for binary files; may be NULL
+ *
+ * @return SaveMOSAIC's or SaveBinaryRows' return value
+ */
+int SaveCanvas (Canvas *canvas, const char *file_name, int *rows_done);
+/**
+ * Copies the canvas as it is now, to be saved while it's still edited
+ *
+ * The snapshot isn't listed with the canvases, and has no view. It
+ * shares the canvas' source, so it must be freed (FreeSnapshot) in the
+ * thread that edits the canvas, but can be saved in any other.
+ *
+ * @param[in] canvas The canvas
+ * @param[in] reveal Decode everything still in the source first, as text
+ * saves over it's file truncate it (see OverwritesSource)
+ *
+ * @return The snapshot
+ */
+Canvas *SnapshotCanvas (Canvas *canvas, char reveal);
+/**
+ * Frees a snapshot made by SnapshotCanvas
+ */
+void FreeSnapshot (Canvas *snapshot);
+/**
+ * Exchanges the canvas' contents and view position with a snapshot's, for
+ * undoing and redoing; the snapshot gets what the canvas had
+ *
+ * @param[in] canvas The canvas
+ * @param[in,out] snapshot A snapshot of it, from SnapshotCanvas
+ * @param[in] height The view's new height
+ * @param[in] width The view's new width
+ */
+void SwapSnapshot (Canvas *canvas, Canvas *snapshot, int height, int width);
+/**
+ * Replaces the canvas' contents by img, that is copied
+ *
+ * @note What the canvas had is recorded, for undo
+ */
+void SetCanvasMOSAIC (Canvas *canvas, MOSAIC *img);
+/**
+ * Loads a file in the canvas, that takes it's dimensions; binary files
+ * are mapped, and decoded as the view reaches them
+ *
+ * @note Rows found corrupted when decoded are left blank, and counted (see
+ * NewCorruptedRows); what the canvas had is recorded, for undo
+ *
+ * @return LoadMOSAIC's or OpenBinary's return value
+ */
+int LoadCanvas (Canvas *canvas, const char *file_name);
+/**
+ * How many rows of img's source were found corrupted, and left blank, since
+ * the last call; they're found as the view reaches them
+ *
+ * @return The rows; 0 if img isn't a canvas
+ */
+int NewCorruptedRows (CURS_MOS *img);
+/**
+ * Would saving img in file_name overwrite the file it's source came from,
+ * where rows were found corrupted? Their blanks would replace what's left
+ * of them for good.
+ */
+int OverwritesCorrupted (CURS_MOS *img, const char *file_name);
+/**
+ * Would saving img in file_name overwrite the file it's source is mapped
+ * from, with bands still to be decoded from it?
+ */
+int OverwritesSource (CURS_MOS *img, const char *file_name);
+/**
+ * Is img a canvas whose view is the whole image, that can be edited as an
+ * ordinary image once it's not stowed (UnstowCanvas)?
+ */
+int WholeCanvas (CURS_MOS *img);
+/**
+ * Makes the tiles of img, a canvas whose view was resized in place (by
+ * TrimCURS_MOS, or undoing what was done before it was a canvas), the view
+ * at 0/0: it's the whole image then; nothing happens if img isn't a canvas
+ */
+void FitCanvas (CURS_MOS *img);
+/**
+ * Stows the views of the canvases that are whole (WholeCanvas) in their
+ * tiles, but current's: they shrink to 1x1, and their pads too
+ *
+ * @note What reads canvases from the tiles (ReadCanvasCells) is unaffected
+ */
+void StowCanvases (CURS_MOS *current);
+/**
+ * An image's whole contents: img's MOSAIC, or for canvases a copy of the
+ * tiles
+ *
+ * @param[in] img The image
+ * @param[out] copy Whether it's a copy, to be freed with FreeMOSAIC
+ *
+ * @return The contents; NULL if there's no memory for a canvas' copy
+ */
+MOSAIC *WholeMOSAIC (CURS_MOS *img, char *copy);
+/**
+ * Is img a canvas whose view is stowed (StowCanvases)? It's edited in the
+ * tiles then (ReadCanvasCells, WriteCanvasCells), at the view's
+ * coordinates, as the view would be the whole image
+ */
+int StowedCanvas (CURS_MOS *img);
+/**
+ * Materializes img's view from the tiles again, and it's pad, if it was
+ * stowed by StowCanvases; nothing happens otherwise
+ */
+void UnstowCanvas (CURS_MOS *img);
+/**
+ * Frees every canvas' tiles (the views are freed with the IMGS)
+ */
+void DestroyCanvases ();
+
+#endif
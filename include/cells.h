@@ -0,0 +1,108 @@
+/** @file cells.h
+ * Cell level helpers, bridging the MOSAIC storage and the CURS_MOS pad
+ */
+
+#ifndef CELLS_H
+#define CELLS_H
+
+#include <mosaic/cursmos.h>
+#include "positioning.h"
+
+/**
+ * Index of a cell in the MOSAIC storage
+ *
+ * The MOSAIC keeps it's chars and attributes as two row-major
+ * height * width arrays, so rows are contiguous and columns are strided
+ */
+#define MOS_INDEX(img, y, x) ((y) * (img)->width + (x))
+
+/// FillRect writes the chars
+#define FILL_CH		0x1
+/// FillRect writes the attributes
+#define FILL_ATTR	0x2
+
+/**
+ * Converts a mos_attr into the curses attributes used in the pads
+ *
+ * @param[in] attr The Mosaic attribute (color pair, bold, underline)
+ *
+ * @return The curses attributes, ready to be OR'ed with a char
+ */
+chtype CursesAttr (mos_attr attr);
+/**
+ * Rewrites a horizontal span of cells in the pad, from the MOSAIC storage
+ *
+ * @note The span is clipped to the image, so out of bounds spans are safe
+ *
+ * @param[in] current The target CURS_MOS
+ * @param[in] y The row
+ * @param[in] from First column in the span
+ * @param[in] to Last column in the span (inclusive)
+ */
+void RewriteSpan (CURS_MOS *current, int y, int from, int to);
+/**
+ * Rewrites a rectangle of cells in the pad, from the MOSAIC storage
+ *
+ * @note The rectangle is clipped to the image
+ *
+ * @param[in] current The target CURS_MOS
+ * @param[in] ULy Upper-left corner Y coordinate
+ * @param[in] ULx Upper-left corner X coordinate
+ * @param[in] BRy Bottom-right corner Y coordinate (inclusive)
+ * @param[in] BRx Bottom-right corner X coordinate (inclusive)
+ */
+void RewriteRect (CURS_MOS *current, int ULy, int ULx, int BRy, int BRx);
+/**
+ * Shifts a line one cell in dir, starting at y/x, for insertion
+ *
+ * The cell at the border in dir is dropped, and y/x is left as it was,
+ * ready to be overwritten. Rows are moved with memmove, columns (UP/DOWN)
+ * in a single strided pass.
+ *
+ * @note This writes only the MOSAIC storage: mark the line dirty afterwards
+ *
+ * @param[in,out] img The target MOSAIC
+ * @param[in] y Y coordinate where the shift starts
+ * @param[in] x X coordinate where the shift starts
+ * @param[in] dir Direction in which the line is pushed
+ */
+void ShiftLine (MOSAIC *img, int y, int x, Direction dir);
+/**
+ * Scrolls the MOSAIC storage and the pad together, as a view moving dy rows
+ * and dx columns over a bigger image: what was at y + dy/x + dx goes to y/x
+ *
+ * Rows are moved with memmove; the pad is scrolled by curses when only
+ * rows move, or has it's rows copied over otherwise.
+ *
+ * @note The cells scrolled in are left as they were: write them, and mark
+ * them dirty, afterwards
+ *
+ * @param[in,out] current The target CURS_MOS
+ * @param[in] dy Rows moved; negative to go up
+ * @param[in] dx Columns moved; negative to go left
+ */
+void ScrollCells (CURS_MOS *current, int dy, int dx);
+/**
+ * Fills a rectangle with a char and/or an attribute
+ *
+ * The rectangle is clipped once, then each row span is written straight
+ * into the MOSAIC storage: the first one with memset (or by doubling
+ * memcpy's, for wider types), and the others copied from it. Full width
+ * rectangles are contiguous, so they're filled as a single span.
+ *
+ * @note This writes only the MOSAIC storage: mark the rectangle dirty
+ * afterwards
+ *
+ * @param[in,out] img The target MOSAIC
+ * @param[in] ULy Upper-left corner Y coordinate
+ * @param[in] ULx Upper-left corner X coordinate
+ * @param[in] BRy Bottom-right corner Y coordinate (inclusive)
+ * @param[in] BRx Bottom-right corner X coordinate (inclusive)
+ * @param[in] c The char to fill with
+ * @param[in] attr The attribute to fill with
+ * @param[in] what What to fill: FILL_CH, FILL_ATTR or both OR'ed
+ */
+void FillRect (MOSAIC *img, int ULy, int ULx, int BRy, int BRx,
+		mos_char c, mos_attr attr, int what);
+
+#endif
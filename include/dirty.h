@@ -0,0 +1,57 @@
+/** @file dirty.h
+ * Dirty regions: what changed in a MOSAIC since its pad was last written
+ */
+
+#ifndef DIRTY_H
+#define DIRTY_H
+
+#include <mosaic/cursmos.h>
+
+/// How many separate rectangles we track before collapsing them into one
+#define DIRTY_RECTS 16
+
+/// A rectangle of cells, corners included
+typedef struct {
+	int ULy;	///< upper-left corner Y coordinate
+	int ULx;	///< upper-left corner X coordinate
+	int BRy;	///< bottom-right corner Y coordinate
+	int BRx;	///< bottom-right corner X coordinate
+} Rect;
+
+/**
+ * Marks a rectangle as dirty, so that it's rewritten in the next display
+ *
+ * Overlapping or adjacent rectangles are merged. If there's dirt pending
+ * for another CURS_MOS, it's flushed first, as we track only one at a time.
+ *
+ * @note The rectangle is clipped to the image, and empty ones are ignored
+ *
+ * @param[in] img The edited CURS_MOS
+ * @param[in] ULy Upper-left corner Y coordinate
+ * @param[in] ULx Upper-left corner X coordinate
+ * @param[in] BRy Bottom-right corner Y coordinate
+ * @param[in] BRx Bottom-right corner X coordinate
+ */
+void MarkDirty (CURS_MOS *img, int ULy, int ULx, int BRy, int BRx);
+/**
+ * Marks the whole image as dirty
+ *
+ * @param[in] img The edited CURS_MOS
+ */
+void MarkAllDirty (CURS_MOS *img);
+/**
+ * Rewrites the dirty cells in their pad, and forget them
+ *
+ * @note This doesn't refresh anything, just writes the pad
+ *
+ * @return How many rectangles were rewritten
+ */
+int FlushDirty ();
+/**
+ * Forgets the dirt in img, as when it's pad is going to be rewritten anyway
+ *
+ * @param[in] img The CURS_MOS whose dirt is discarded
+ */
+void DiscardDirty (CURS_MOS *img);
+
+#endif
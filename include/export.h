@@ -0,0 +1,54 @@
+/** @file export.h
+ * Exporting images out of the editor, with no curses at all
+ */
+
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <mosaic/mosaic.h>
+#include <stdio.h>
+
+/**
+ * Writes an image as text with ANSI escape sequences
+ *
+ * Cells are written a run of the same attribute at a time, and SGR
+ * sequences carry only what changed from the last attribute. Blanks that
+ * wouldn't show at the end of a line are left out, and the attributes are
+ * reset at the end of each line, so nothing bleeds. Output goes through a
+ * big buffer, out in a few large writes.
+ *
+ * @param[in] img The image
+ * @param[in] out Where to write it
+ *
+ * @return 0 on success, or the errno of the failed write
+ */
+int ExportANSI (MOSAIC *img, FILE *out);
+/**
+ * Writes an image as plain text, attributes dropped
+ *
+ * @param[in] img The image
+ * @param[in] out Where to write it
+ *
+ * @return 0 on success, or the errno of the failed write
+ */
+int ExportText (MOSAIC *img, FILE *out);
+/**
+ * A load error's description
+ *
+ * @param[in] err LoadMOSAIC's return value
+ *
+ * @return A static string with the description
+ */
+const char *LoadError (int err);
+/**
+ * Headless mode: loads a file and writes it to stdout, without curses
+ *
+ * @param[in] file_name The .mosi file
+ * @param[in] dimensions Print the dimensions, as HEIGHTxWIDTH
+ * @param[in] color Print the image, as ANSI text
+ *
+ * @return The exit status: 0 if everything went fine, 1 otherwise
+ */
+int Headless (const char *file_name, char dimensions, char color);
+
+#endif
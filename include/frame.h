@@ -0,0 +1,33 @@
+/** @file frame.h
+ * Frame pacing: apply every queued key, then update the screen once
+ */
+
+#ifndef FRAME_H
+#define FRAME_H
+
+/// Default maximum screen updates per second
+#define DEFAULT_MAX_FPS 60
+
+/**
+ * Sets the maximum frame rate
+ *
+ * @param[in] fps Maximum screen updates per second; 0 for no limit
+ */
+void SetMaxFrameRate (int fps);
+/**
+ * Gets the next key that belongs to the current frame
+ *
+ * Queued input is returned right away. If there's none, it waits for more
+ * input only until the next frame is due, so key-repeat bursts get
+ * coalesced into a single screen update.
+ *
+ * @return The key, or ERR if it's time to draw the frame
+ */
+int NextFrameKey ();
+/**
+ * Ends the frame, sending everything staged with the `noutrefresh`
+ * functions to the terminal in a single `doupdate`
+ */
+void EndFrame ();
+
+#endif
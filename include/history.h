@@ -0,0 +1,112 @@
+/** @file history.h
+ * Undo/redo journal, with bounded memory
+ *
+ * Every edit saves the cells it's about to change in a record; an undo
+ * step is the records of one user action. Undoing and redoing swap the
+ * recorded cells with the image's, so each record serves both ways.
+ *
+ * Steps may be joined, as one user action editing many images: they're
+ * undone and redone together.
+ *
+ * Steps in a canvas are in it's view's coordinates, so they remember where
+ * the view was, and put it back there before being undone or redone.
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <mosaic/cursmos.h>
+
+/// Default memory cap for the journal, in KB
+#define DEFAULT_HISTORY_KB 16384
+
+/**
+ * Sets the journal's memory cap; oldest steps are evicted to respect it
+ *
+ * @note The step being recorded is never evicted, even if it's bigger
+ *
+ * @param[in] kb The cap, in KB
+ */
+void SetHistoryLimit (int kb);
+/**
+ * Joins the steps opened from now on, so they're undone and redone
+ * together, as one user action across images
+ *
+ * @note Like the step being recorded, the last joined steps are never
+ * evicted, even if they're bigger than the cap
+ *
+ * @param[in] join 1 to start joining, 0 when the action is done
+ */
+void JoinEdits (char join);
+/**
+ * Starts recording a new user action in img
+ *
+ * @param[in] img The image about to be edited
+ * @param[in] coalesce Whether this may be merged with the previous step,
+ * if it's also coalescing and touches it (like typing or painting)
+ */
+void BeginEdit (CURS_MOS *img, char coalesce);
+/**
+ * Records a rectangle of cells, before they're changed
+ *
+ * @note The rectangle is clipped to the image; cells already recorded in
+ * the same step by the last record aren't recorded again
+ *
+ * @param[in] img The image about to be edited
+ * @param[in] ULy Upper-left corner Y coordinate
+ * @param[in] ULx Upper-left corner X coordinate
+ * @param[in] BRy Bottom-right corner Y coordinate
+ * @param[in] BRx Bottom-right corner X coordinate
+ */
+void RecordRect (CURS_MOS *img, int ULy, int ULx, int BRy, int BRx);
+/**
+ * Records the whole image, before it's dimensions change (Resize, Trim, Load)
+ *
+ * @note Canvases are recorded whole with RecordCanvas
+ *
+ * @param[in] img The image about to be changed
+ */
+void RecordImage (CURS_MOS *img);
+/**
+ * Records a whole canvas, before it's dimensions or contents change
+ * (resizes and loads)
+ *
+ * The canvas is kept as a snapshot (SnapshotCanvas), sharing it's tiles
+ * copy-on-write, along with the view's dimensions, so it costs only what's
+ * edited after.
+ *
+ * @param[in] img The canvas' view
+ */
+void RecordCanvas (CURS_MOS *img);
+/**
+ * Undoes the last step
+ *
+ * @return The changed image, or NULL if there's nothing to undo
+ */
+CURS_MOS *Undo ();
+/**
+ * Redoes the last undone step
+ *
+ * @return The changed image, or NULL if there's nothing to redo
+ */
+CURS_MOS *Redo ();
+/**
+ * Drops every step made in img, for when they can't be undone anymore
+ *
+ * @param[in] img The image
+ */
+void ForgetHistory (CURS_MOS *img);
+/**
+ * How many changes were made to the images so far
+ *
+ * Everything that changes an image is recorded (or undone, redone, or
+ * makes the history be forgotten), so this tells if there's something
+ * new since some point, like the last autosave.
+ */
+unsigned long EditCount ();
+/**
+ * Destroys the journal, freeing it's memory
+ */
+void DestroyHistory ();
+
+#endif
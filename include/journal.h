@@ -0,0 +1,102 @@
+/** @file journal.h
+ * Journaled saves: only the changed cells are appended to a sidecar file
+ *
+ * An image loaded from (or saved to) a file remembers it, and which cells
+ * changed since. Saving it to that file again appends just those cells to
+ * FILE.journal, so a save costs as much as the edit, not the image. The
+ * file itself, the checkpoint, is only rewritten (and the journal dropped)
+ * when the journal would grow past the limit, or after a change in the
+ * image's shape.
+ *
+ * Layout, integers little-endian:
+ *
+ * | bytes           | what                                               |
+ * |-----------------|----------------------------------------------------|
+ * | 4               | "MOSJ"                                             |
+ * | 1               | format version (JOURNAL_VERSION)                   |
+ * | 3               | reserved, 0                                        |
+ * | 8               | the checkpoint's size                              |
+ * | 8 + 4           | the checkpoint's mtime: seconds, nanoseconds       |
+ * | 4               | reserved, 0                                        |
+ * | ...             | records: y, x, height, width (4 bytes each), then  |
+ * |                 | the cells' chars (1 byte) and attributes (4 bytes) |
+ *
+ * The checkpoint's size and mtime tell if the journal still belongs to it:
+ * if the file was rewritten some other way, the journal is ignored. A
+ * record cut short (by a crash while appending) ends the replay.
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <mosaic/cursmos.h>
+#include "canvas.h"
+
+/// Appended to the checkpoint's name, for the journal's
+#define JOURNAL_SUFFIX ".journal"
+/// The journal format version we write (and read)
+#define JOURNAL_VERSION 1
+/// Default journal size limit, in KB; 0 means saves aren't journaled
+#define DEFAULT_JOURNAL_KB 0
+
+/**
+ * Sets how big a journal may get before the checkpoint is rewritten
+ *
+ * @param[in] kb The limit, in KB; 0 disables journaling
+ */
+void SetJournalLimit (int kb);
+/**
+ * Notes that a rectangle of img is changing, to be journaled on next save
+ *
+ * @note Called by the history, as it records every edit; for canvases,
+ * the coordinates are in the view
+ */
+void JournalRect (CURS_MOS *img, int ULy, int ULx, int BRy, int BRx);
+/**
+ * Notes that img changed as a whole, so the next save is a checkpoint
+ */
+void JournalWhole (CURS_MOS *img);
+/**
+ * Ties img to the file it was just loaded from: it's the checkpoint, and
+ * nothing changed since
+ */
+void JournalAttach (CURS_MOS *img, const char *file_name);
+/**
+ * Marks the start of a checkpoint: img's changes so far are going to the
+ * file being written, so only the ones from now on are tracked
+ */
+void StartCheckpoint (CURS_MOS *img);
+/**
+ * Marks the end of a checkpoint: img is tied to the written file, whose
+ * old journal is removed
+ *
+ * @param[in] img The image
+ * @param[in] file_name The checkpoint
+ * @param[in] ret The save's return value; if not 0, the next save is a
+ * checkpoint again
+ */
+void EndCheckpoint (CURS_MOS *img, const char *file_name, int ret);
+/**
+ * Saves img's changes to file_name's journal, if they can be
+ *
+ * They can if file_name is img's checkpoint, still as img left it, the
+ * image's shape didn't change and the journal stays under the limit.
+ *
+ * @return 0 if the changes are saved, ERR if a checkpoint is needed, or
+ * the errno of a failed write (and a checkpoint should be tried)
+ */
+int AppendJournal (CURS_MOS *img, const char *file_name);
+/**
+ * Applies file_name's journal, if it has one, over img just loaded from it
+ */
+void ReplayJournal (const char *file_name, MOSAIC *img);
+/**
+ * Applies file_name's journal, if it has one, over canvas just loaded from it
+ */
+void ReplayJournalCanvas (const char *file_name, Canvas *canvas);
+/**
+ * Frees the journaling state of every image
+ */
+void DestroyJournals ();
+
+#endif
@@ -25,5 +25,7 @@
 #define KEY_CTRL_V 22
 #define KEY_CTRL_W 23
 #define KEY_CTRL_X 24
+#define KEY_CTRL_Y 25
+#define KEY_CTRL_Z 26
 
 #endif
@@ -16,6 +16,19 @@
 #include "positioning.h"
 #include "state.h"
 #include "keys.h"
+#include "cells.h"
+#include "dirty.h"
+#include "blit.h"
+#include "history.h"
+#include "canvas.h"
+#include "binary.h"
+#include "async.h"
+#include "autosave.h"
+#include "journal.h"
+#include "play.h"
+#include "video.h"
+#include "onion.h"
+#include "range.h"
 
 #define BOUNDARY_Y (LINES)
 #define BOUNDARY_X (COLS)
@@ -34,17 +47,18 @@ int toUTF8 ();
 /**
  * The copy buffer
  * 
- * CopyBuffer is used at the Copy/Cut and Paste functions.
+ * CopyBuffer is used at the Copy/Cut and Paste functions. It stores only
+ * the selected cells, as row-major height * width arrays, just like the
+ * MOSAIC does, so pasting is a block copy.
  * 
  * @warning CopyBuffers must be destroid before the program exits,
  * to avoid memory leaks!
  */
 typedef struct {
-	WINDOW *buff;		///< WINDOW that stores the mosaic
-	Cursor coordinates;	/**< copy coordinates: origin_y/x for the upper-left
-   						 * corner, y/x for the size (how many chars 
-						 * in each direction) 
-						 */
+	mos_char *chars;	///< the copied chars; NULL if nothing was copied
+	mos_attr *attrs;	///< the copied attributes
+	int height;	///< how many rows were copied
+	int width;	///< how many columns were copied
 } CopyBuffer;
 /**
  * Initializes the copy buffer with default empty falues
@@ -82,6 +96,39 @@ void Cut (CopyBuffer *buffer, CURS_MOS *current, Cursor selection);
  * @param[in] cursor The position to paste from
  */
 char Paste (CopyBuffer *buffer, CURS_MOS *current, Cursor cursor);
+/**
+ * Asks for an edit and a range of images, and does the edit at the same
+ * place in each of them (see EditRange)
+ *
+ * Fill, recolor and erase act on the selection (or the cursor's cell, if
+ * there's none); paste puts the buffer at the cursor.
+ *
+ * @param[in] everyone All the images
+ * @param[in] current The current mosaic
+ * @param[in] cursor The cursor, and the selection
+ * @param[in] buffer The copy buffer, for pasting
+ * @param[in] attr The attribute to fill or recolor with
+ *
+ * @return How many images were edited; 0 if none, or canceled
+ */
+int EditImages (IMGS *everyone, CURS_MOS *current, Cursor cursor,
+		CopyBuffer *buffer, mos_attr attr);
+/**
+ * Sets which cells are skipped by transparent pasting
+ *
+ * @note The default key is a blank with the Normal attribute
+ *
+ * @param[in] key The new transparency key
+ */
+void SetTransparentKey (BlitKey key);
+/**
+ * Creates a pad with the copy buffer's contents, for displaying it
+ *
+ * @param[in] buffer The copy buffer
+ *
+ * @return The new pad, to be deleted by the caller; NULL if buffer is empty
+ */
+WINDOW *CopyBufferPad (CopyBuffer *buffer);
 
 
 /**
@@ -92,6 +139,8 @@ void DefaultDirection (Direction *dir);
 /**
  * Create a new image and store it in the images list
  * 
+ * Images with a side bigger than MAX_DENSE_SIDE are created as canvases
+ * 
  * @param[in|out] everyone The mosaics list
  * @param[in] current The current mosaic, a reference for the new one coming
  * 
@@ -102,12 +151,18 @@ CURS_MOS *CreateNewMOSAIC (IMGS *everyone, CURS_MOS *current);
 /**
  * Resizes the current image (or not, it's interactive)
  *
+ * @note Images resized beyond MAX_DENSE_SIDE become canvases
+ *
  * @param[in|out] current The target CURS_MOS
  */
 void Resize (CURS_MOS *current, Cursor *cursor);
 /**
  * Displays the current MOSAIC, and it's border (using dobox)
  *
+ * @note Only the dirty cells are rewritten in the pad, unless
+ * the REDRAW state asks for everything
+ * @note Everything is staged only; call `doupdate` (or EndFrame) to show it
+ *
  * @param[in] current The current CURS_MOS
  */
 void DisplayCurrent (CURS_MOS *current);
@@ -169,27 +224,76 @@ void InsertCh (CURS_MOS *current, Cursor *cur, int c, mos_attr attr,
  */
 void ChAttrs (CURS_MOS *current, Cursor *cur, mos_attr attr);
 /**
- * Loads an image in the current
+ * Asks for a file, and starts loading it in the current, in the background;
+ * videos are loaded right away, as new images after the current
+ *
+ * @param[in,out] everyone All the images
+ * @param[in,out] current The current image; a video's first frame, after
+ * loading one
  *
- * @return Return value of LoadMOSAIC, or ERR if canceled
+ * @return StartLoad's or LoadVideo's return value, or ERR if canceled
  */
-int Load (CURS_MOS *current);
+int Load (IMGS *everyone, CURS_MOS **current);
 /**
- * Saves an image in the current
+ * Loads a file in the current, text or binary, whatever it's name
  *
- * @return Return value of LoadMOSAIC, or ERR if canceled
+ * Binary files too big for an ordinary image make current a canvas, that
+ * decodes them lazily (LoadCanvas).
+ *
+ * @return LoadCURS_MOS's or LoadBinary's return value
+ */
+int LoadAnyCURS_MOS (CURS_MOS *current, const char *file_name);
+/**
+ * Asks for a file, and starts saving the current in it, in the background;
+ * binary if it's name ends in .mosb, or else as .mosi. Names ending in
+ * .mosv save every image as a video, right away
+ *
+ * @param[in] everyone All the images
+ * @param[in] current The current image
+ *
+ * @note The changes are taken as saved (TOUCHED is left) only when the
+ * file is complete: right away for videos and journal appends, or in
+ * PollFileIO, if nothing changed while saving in the background
+ *
+ * @return StartSave's return value, or ERR if canceled (or the video
+ * couldn't be saved)
+ */
+int Save (IMGS *everyone, CURS_MOS *current);
+/**
+ * Shows the background load/save's progress in the HUD, and when it's
+ * done, how it went
+ *
+ * @param[in] current The current image
+ * @param[in,out] cursor The cursor, moved inside current if a load
+ * resized it
  */
-int Save (CURS_MOS *current);
+void PollFileIO (CURS_MOS *current, Cursor *cursor);
+/**
+ * Erases a run of n cells, as n Backspaces would, but in a single pass
+ *
+ * The run starts at the cell before the cursor and goes in dir, stopping
+ * at the border; the cursor ends up at it's last cell.
+ *
+ * @note In selection mode, the selection is blanked instead, as Backspace does
+ *
+ * @param[in,out] cursor Current cursor position
+ * @param[in] current The current CURS_MOS
+ * @param[in] dir Direction for the erasure
+ * @param[in] n How many cells to erase
+ */
+void EraseSpan (Cursor *cursor, CURS_MOS *current, Direction dir, int n);
 /**
  * Erases an entire line from current (MOSAIC and WINDOW).
  * 
+ * @param[in,out] cursor Current cursor position
  * @param[in] current The current CURS_MOS
+ * @param[in] dir Direction for the erasure
  */
-void EraseLine (CURS_MOS *current);
+void EraseLine (Cursor *cursor, CURS_MOS *current, Direction dir);
 /**
  * Erases a word from current (until a blank ' ').
  * 
- * @param[in] cursor Current cursor position
+ * @param[in,out] cursor Current cursor position
  * @param[in] current The current CURS_MOS
  * @param[in] dir Direction for the erasure
  */
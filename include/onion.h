@@ -0,0 +1,53 @@
+/** @file onion.h
+ * Onion skin: the images before and after the current one, dimmed under it
+ *
+ * Where the current image is blank, it's pad shows what the previous and
+ * next images have in the same place, dimmed (the previous one wins where
+ * both have something). What shows through is kept in a cache for the
+ * current image: it's built once when the image becomes current, and
+ * afterwards only the parts the neighbours mark dirty are built again, so
+ * moving around or typing composes just the cells rewritten anyway.
+ */
+
+#ifndef ONION_H
+#define ONION_H
+
+#include <mosaic/cursmos.h>
+
+/**
+ * The cells that show through img's blank ones in row y
+ *
+ * @return The row's cells, 0 where nothing shows through; NULL if img isn't
+ * showing the onion skin
+ */
+const chtype *OnionRow (CURS_MOS *img, int y);
+/**
+ * Tells the onion skin that a rectangle of img changed, as MarkDirty does
+ *
+ * If img is under the current image, that part is composed again in the
+ * next UpdateOnion.
+ */
+void OnionDirty (CURS_MOS *img, int ULy, int ULx, int BRy, int BRx);
+/**
+ * Brings the cache up to date with current and the ONION state
+ *
+ * Parts the neighbours dirtied are marked dirty in current. When current
+ * or it's neighbours are other than the cache's, or the onion skin was
+ * turned off, the last image's pad is rewritten without it.
+ *
+ * @return 1 if current's pad needs to be rewritten whole, 0 otherwise
+ */
+int UpdateOnion (CURS_MOS *current);
+/**
+ * Writes in current's pad, over it's blank cells, what shows through them
+ *
+ * For after the pad is rewritten by something that doesn't know about the
+ * onion skin, like RewriteCURS_MOS
+ */
+void OverlayOnion (CURS_MOS *current);
+/**
+ * Frees the cache
+ */
+void DestroyOnion ();
+
+#endif
@@ -0,0 +1,47 @@
+/** @file play.h
+ * Playback: the images shown in turn as an animation's frames
+ *
+ * Frames are drawn in a window over the pads, that remembers what it
+ * shows: each frame writes only the cells that differ from the last, so a
+ * mostly still animation sends the terminal little more than what moves.
+ * If drawing falls behind the frame rate, frames are dropped to keep the
+ * pace, and counted.
+ */
+
+#ifndef PLAY_H
+#define PLAY_H
+
+#include <mosaic/cursmos.h>
+
+/// Default playback speed, in frames per second
+#define DEFAULT_PLAY_FPS 12
+
+/// How a playback went
+typedef struct {
+	int shown;	///< frames drawn
+	int dropped;	///< frames skipped, as drawing was late for them
+	long cells;	///< cells written; the others were just as in the last frame
+} PlayStats;
+
+/**
+ * Sets the playback speed
+ *
+ * @param[in] fps Frames per second; anything below 1 is taken as 1
+ */
+void SetPlayRate (int fps);
+/**
+ * Plays the images, from current on and going round the IMGS, until a
+ * key is pressed (and consumed)
+ *
+ * @note The pads aren't touched: the caller must copy the current one to
+ * the screen again (touchwin) afterwards
+ *
+ * @param[in] everyone All the images
+ * @param[in] current The first frame
+ * @param[out] stats How it went
+ *
+ * @return The frame showing when the key was pressed
+ */
+CURS_MOS *Play (IMGS *everyone, CURS_MOS *current, PlayStats *stats);
+
+#endif
@@ -11,6 +11,9 @@
 #define MOSAIC_PAD_HEIGHT (LINES - 2)
 #define MOSAIC_PAD_WIDTH (COLS - 1)
 
+/// How close to the view's borders the cursor gets before it scrolls
+#define DEFAULT_SCROLL_MARGIN 3
+
 /// UI current cursor position
 typedef struct {
 	int y;	///< main y coordinate
@@ -55,20 +58,57 @@ void InitCursor (Cursor *cursor);
 
 /**
  * Displays current CURS_MOS, just that
+ *
+ * @note The pad is only staged (`pnoutrefresh`), so a `doupdate` is needed
+ * for it to reach the terminal
  */
 void DisplayCurrent (CURS_MOS *current);
 
 /**
  * Prints in the current window the selection box
+ *
+ * @note Only the cells that entered or left the box since the last print
+ * are touched, so dragging a selection costs its border, not the image
  */
 void PrintSelection (Cursor *position, CURS_MOS *current);
 /**
- * Unprints the selection box 
+ * Reprints the selection box, after the pad was rewritten under it
+ *
+ * @param[in] current The rewritten CURS_MOS; nothing happens if the box
+ * is not printed there
+ */
+void ReprintSelection (CURS_MOS *current);
+/**
+ * Unprints the selection box, rewriting only the cells that were in it
  */
 void UnprintSelection (CURS_MOS *current);
+/**
+ * Sets the scrolling margin
+ *
+ * @param[in] margin How many cells must be kept between the cursor and the
+ * view's borders; it's capped to half the view
+ */
+void SetScrollMargin (int margin);
+/**
+ * Scrolls a view, in one dimension, so that the cursor stays in it
+ *
+ * The view moves only what's needed to keep the scrolling margin, and
+ * never goes past the image
+ *
+ * @param[in] start The view's first cell
+ * @param[in] view The view's size
+ * @param[in] length The image's size
+ * @param[in] pos The cursor position
+ *
+ * @return The view's new first cell
+ */
+int FollowPosition (int start, int view, int length, int pos);
 /**
  * Move the cursor to the desired position (for clicking)
  *
+ * The view (CURS_MOS::y/x, the pad cell shown at the screen's upper-left
+ * corner) scrolls along, if needed
+ *
  * @param[in] position Actual working position
  * @param[in] current Current image, for knowing the boundaries
  * @param[in] y Y coordinate
@@ -103,7 +143,20 @@ void MoveAll (Cursor *position, CURS_MOS *current, Direction dir);
 void MoveResized (Cursor *position, CURS_MOS *current);
 
 /**
- * Returns mosaic in `everyone[index]' (sort of)
+ * Links a new image in everyone, after or before current, keeping the
+ * index GoToPage and PageIndex look images up in
+ *
+ * @note Every image must be added by this, so the index matches the list
+ *
+ * @param[in,out] everyone All the images
+ * @param[in] current The image img goes next to; ignored if it's the first
+ * @param[in] img The new image
+ * @param[in] dir Whether img goes after or before current
+ */
+void AddPage (IMGS *everyone, CURS_MOS *current, CURS_MOS *img,
+		enum direction dir);
+/**
+ * Returns mosaic in `everyone[index]', looked up in the index
  *
  * @note index starts from 0
  *
@@ -114,6 +167,20 @@ void MoveResized (Cursor *position, CURS_MOS *current);
  * @return NULL if index greater than size
  */
 CURS_MOS * GoToPage (IMGS *everyone, unsigned int index);
+/**
+ * Returns the index of a mosaic in everyone (GoToPage's inverse)
+ *
+ * @param[in] everyone All the images
+ * @param[in] img The mosaic we want the index of
+ *
+ * @return img's index
+ * @return -1 if img isn't in everyone
+ */
+int PageIndex (IMGS *everyone, CURS_MOS *img);
+/**
+ * Frees the images' index (the images are freed with the IMGS)
+ */
+void DestroyPages ();
 /**
  * Changes the default direction for the movement
  * 
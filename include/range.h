@@ -0,0 +1,63 @@
+/** @file range.h
+ * Range edits: the same paste, fill, recolor or erase, at the same
+ * coordinates, in each image of a range
+ *
+ * The cells about to change are recorded first, in the images' order, as
+ * joined undo steps, so the whole range is undone at once. The images
+ * are then edited by a pool of worker threads, each taking the next
+ * image, as they're independent MOSAICs. Last, the other images' pads
+ * are rewritten where they changed, and the current one is just marked
+ * dirty: it's the only one drawn.
+ *
+ * Canvases are left out, as their views aren't in the same place; but not
+ * whole ones (duplicated images, see WholeCanvas), edited in their views
+ * as ordinary images. Or, if they're stowed (StowedCanvas), edited and
+ * recorded in their tiles, by this thread, so they stay stowed and their
+ * pads aren't written.
+ */
+
+#ifndef RANGE_H
+#define RANGE_H
+
+#include <mosaic/cursmos.h>
+#include "blit.h"
+
+/// Cells worth a worker thread of their own
+#define RANGE_CELLS_PER_JOB 65536
+
+/// What a range edit does in each image
+typedef enum {
+	RANGE_PASTE,	///< blits src, with key, at rect's upper-left corner
+	RANGE_FILL,	///< fills rect with ch and attr
+	RANGE_RECOLOR,	///< fills rect with attr, keeping the chars
+	RANGE_ERASE	///< fills rect with blanks
+} RangeOp;
+
+/// A range edit
+typedef struct {
+	RangeOp op;	///< what it does
+	Rect rect;	///< the cells; for RANGE_PASTE, only the corner is used
+	mos_char ch;	///< the char, for RANGE_FILL
+	mos_attr attr;	///< the attribute, for RANGE_FILL and RANGE_RECOLOR
+	BlitSource src;	///< the cells, for RANGE_PASTE
+	BlitKey key;	///< the transparency key, for RANGE_PASTE
+} RangeEdit;
+
+/**
+ * Does edit in the images from first to last, by index (see PageIndex)
+ *
+ * @param[in] everyone All the images
+ * @param[in] current The image being shown
+ * @param[in] first First image's index
+ * @param[in] last Last image's index, inclusive; taken as first if lesser
+ * @param[in] edit The edit
+ * @param[in] jobs How many workers, at most; 0 for one per online CPU
+ * @param[out] skipped How many canvases were left out (but whole ones,
+ * see WholeCanvas)
+ *
+ * @return How many images were edited, or ERR if first is out of range
+ */
+int EditRange (IMGS *everyone, CURS_MOS *current, int first, int last,
+		const RangeEdit *edit, int jobs, int *skipped);
+
+#endif
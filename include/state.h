@@ -46,6 +46,10 @@ State state;	///< the global Maae State
 #define REDRAW				0x0080
 /** When moving a selection */
 #define MOVING				0x0100
+/** Needs to copy the pad again, as the view scrolled, and redraw the border */
+#define REBORDER			0x0200
+/** Onion skin: the previous and next images show, dimmed, under this one */
+#define ONION				0x0400
 /** Quit the sw (to break the main loop) */
 #define QUIT				0x8000
 
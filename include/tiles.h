@@ -0,0 +1,110 @@
+/** @file tiles.h
+ * Sparse tile storage, for images far bigger than the screen
+ *
+ * The image is split in TILE_SIZE x TILE_SIZE tiles, allocated only when
+ * something non-blank is written in them, so memory scales with the
+ * content, not with the image's dimensions.
+ *
+ * Copies of a TileMap share the tiles' cells, copy-on-write: copying is
+ * a pointer per tile, and a shared tile's cells are copied only when
+ * written with something different. Reference counts are only touched
+ * by the thread that edits (snapshots are read elsewhere, but created and
+ * freed there), so they need no locking.
+ */
+
+#ifndef TILES_H
+#define TILES_H
+
+#include <mosaic/mosaic.h>
+#include <stddef.h>
+
+/// Tile side, in cells
+#define TILE_SIZE 64
+
+/// A tile's TILE_SIZE x TILE_SIZE cells, row-major, maybe shared
+typedef struct {
+	int refs;	///< how many tiles (in different TileMaps) share them
+	mos_char chars[TILE_SIZE * TILE_SIZE];	///< the chars
+	mos_attr attrs[TILE_SIZE * TILE_SIZE];	///< the attributes
+} TileCells;
+
+/// A tile: where it is, and it's cells
+typedef struct tile {
+	int ty;	///< tile row (cell Y / TILE_SIZE)
+	int tx;	///< tile column (cell X / TILE_SIZE)
+	TileCells *cells;	///< the cells; never written while shared
+	struct tile *next;	///< next tile in the same hash bucket
+} Tile;
+
+/// A sparse image: blank tiles don't exist
+typedef struct {
+	int height;	///< image height, in cells
+	int width;	///< image width, in cells
+	Tile **buckets;	///< hash table of the allocated tiles
+	int n_buckets;	///< the hash table's size
+	int n_tiles;	///< how many tiles are allocated
+} TileMap;
+
+/**
+ * Creates an empty (blank) TileMap
+ *
+ * @param[in] height Image height
+ * @param[in] width Image width
+ *
+ * @return The new TileMap, to be freed with FreeTileMap
+ */
+TileMap *NewTileMap (int height, int width);
+/**
+ * Frees a TileMap and all of it's tiles
+ */
+void FreeTileMap (TileMap *map);
+/**
+ * Creates a copy of a TileMap, sharing the tiles' cells copy-on-write
+ *
+ * @return The copy, to be freed with FreeTileMap
+ */
+TileMap *CopyTileMap (TileMap *map);
+/**
+ * Resizes a TileMap, blanking (and freeing) what's left outside
+ */
+void ResizeTileMap (TileMap *map, int height, int width);
+/**
+ * Gets the tile with the cell y/x, if it's allocated
+ *
+ * @return The tile, or NULL if that part of the image is blank
+ */
+Tile *FindTile (TileMap *map, int y, int x);
+/**
+ * Materializes a region of the TileMap in view
+ *
+ * The region is view's size, with it's upper-left corner at y/x. Cells
+ * outside the map or in blank tiles come out as blanks.
+ *
+ * @param[in] map The TileMap
+ * @param[out] view The MOSAIC that receives the region
+ * @param[in] y Region's upper-left corner Y coordinate
+ * @param[in] x Region's upper-left corner X coordinate
+ */
+void ReadTiles (TileMap *map, MOSAIC *view, int y, int x);
+/**
+ * Stores view back in the TileMap, at y/x (ReadTiles' inverse)
+ *
+ * Tiles are allocated only for non-blank content, and tiles left
+ * all blank are freed. Tiles the view doesn't change are left alone, so
+ * shared ones stay shared.
+ *
+ * @param[in,out] map The TileMap
+ * @param[in] view The MOSAIC with the region
+ * @param[in] y Region's upper-left corner Y coordinate
+ * @param[in] x Region's upper-left corner X coordinate
+ */
+void WriteTiles (TileMap *map, MOSAIC *view, int y, int x);
+/**
+ * Memory used by a TileMap
+ *
+ * @return The bytes used by tiles and the hash table; cells shared by
+ * n TileMaps count 1/n in each
+ */
+size_t TileMapBytes (TileMap *map);
+
+#endif
@@ -0,0 +1,107 @@
+/** @file video.h
+ * Video .mosv files: every image in the IMGS as one animation's frames
+ *
+ * Every DEFAULT_KEYFRAME_INTERVAL frames (and whenever the dimensions
+ * change) comes a keyframe, the whole image; the frames between are
+ * deltas, only the spans of cells that changed since the frame before.
+ * An index at the end tells where each frame is and it's keyframe, so
+ * frame N is decoded from it's keyframe and the deltas up to it, without
+ * reading the rest of the file.
+ *
+ * Layout, integers little-endian:
+ *
+ * | bytes           | what                                               |
+ * |-----------------|----------------------------------------------------|
+ * | 4               | "MOSV"                                             |
+ * | 1               | format version (VIDEO_VERSION)                     |
+ * | 3               | reserved, 0                                        |
+ * | 4               | number of frames                                   |
+ * | 4               | reserved, 0                                        |
+ * | 8               | the index's offset                                 |
+ * | ...             | frames: type (0 key, 1 delta) and 3 reserved bytes,|
+ * |                 | height, width and data length (4 bytes each), data |
+ * | 16 * frames     | index: each frame's offset (8), keyframe (4), 0 (4)|
+ *
+ * A keyframe's data is all it's chars, then all it's attributes, PackBits
+ * encoded like in binary files (PackValues). A delta's is the number of
+ * spans (4 bytes), then for each: cells skipped since the last span's end
+ * and the span's length (4 bytes each), then it's chars and attributes,
+ * also PackBits encoded.
+ */
+
+#ifndef VIDEO_H
+#define VIDEO_H
+
+#include <mosaic/cursmos.h>
+#include <stddef.h>
+
+/// The video files' extension
+#define VIDEO_EXTENSION ".mosv"
+/// The video format version we write (and read)
+#define VIDEO_VERSION 1
+/// Frames from a keyframe to the next
+#define DEFAULT_KEYFRAME_INTERVAL 30
+
+/// An open video file, mapped in memory
+typedef struct {
+	int frames;	///< how many frames there are
+	const unsigned char *data;	///< the whole file
+	size_t size;	///< the file's size
+	size_t index;	///< the index's offset
+} VideoFile;
+
+/**
+ * Is the file a video? (looks at it's contents, not the name)
+ */
+int IsVideo (const char *file_name);
+/**
+ * Should a file with this name be saved as a video? (ends with
+ * VIDEO_EXTENSION)
+ */
+int VideoName (const char *file_name);
+/**
+ * Opens a video file, mapping it and validating the header and index
+ *
+ * @return 0 on success, the errno of a failed open/mmap, ENODIMENSIONS if
+ * it's not a video or EBADMSG if it's corrupted
+ */
+int OpenVideo (VideoFile *video, const char *file_name);
+/**
+ * Decodes a frame of an open video, from it's keyframe on
+ *
+ * @param[in] video The video
+ * @param[in] n The frame, from 0
+ * @param[out] img The frame's image, that takes it's dimensions
+ *
+ * @return 0 on success, EINVAL if there's no such frame, EBADMSG if the
+ * frame (or one it depends on) is corrupted, ENOMEM if there's no memory
+ * to decode it
+ */
+int ReadVideoFrame (VideoFile *video, int n, MOSAIC *img);
+/**
+ * Unmaps a video file
+ */
+void CloseVideo (VideoFile *video);
+/**
+ * Saves every image in everyone, in order, as a video's frames
+ *
+ * @note The file is written aside and renamed over file_name when complete
+ *
+ * @return 0 on success, ENOMEM if there's no memory for a frame (canvases
+ * are made whole to be saved), or the errno of the failed write
+ */
+int SaveVideo (IMGS *everyone, const char *file_name);
+/**
+ * Loads a video's frames as new images, linked after current
+ *
+ * @param[in,out] everyone All the images
+ * @param[in] current The image the frames go after; NULL if there's none
+ * @param[in] file_name The file
+ * @param[out] first The first frame's image; untouched if none was loaded
+ *
+ * @return OpenVideo's or ReadVideoFrame's errors, 0 on success
+ */
+int LoadVideo (IMGS *everyone, CURS_MOS *current, const char *file_name,
+		CURS_MOS **first);
+
+#endif
@@ -19,7 +19,7 @@
 #define ABOUT_WIDTH 50
 
 #define HUD_MSG_X 28
-#define HUD_CURSOR_X 15
+#define HUD_CURSOR_X 17
 
 #define MODES 3
 
@@ -48,8 +48,16 @@ void InitHud ();
  */
 void ReHud ();
 
-/// Updates the position in the HUD
-void UpdateHud (Cursor cur, Direction dir);
+/**
+ * Updates the position in the HUD
+ *
+ * @param[in] current The current image, for canvas coordinates
+ * @param[in] cur The cursor
+ * @param[in] dir The default direction, shown as an arrow
+ *
+ * @note The HUD is only staged (`wnoutrefresh`), for the frame's `doupdate`
+ */
+void UpdateHud (CURS_MOS *current, Cursor cur, Direction dir);
 
 /// For PrintHud execute a `scanw` instead of a getch
 #define SCAN 2
@@ -1,4 +1,13 @@
 #include "argpstuff.h"
+#include "frame.h"
+#include "history.h"
+#include "positioning.h"
+#include "autosave.h"
+#include "journal.h"
+#include "play.h"
+#include <mosaic/color.h>
+
+#include <stdlib.h>
 
 /* ARGP for parsing the arguments */
 #include <argp.h>
@@ -6,20 +15,28 @@
 const char *argp_program_version = "Maae 0.1.0";
 const char *argp_program_bug_address = "<gilzoide@gmail.com>";
 static char doc[] = "Maae, a Curses and Mosaic based asc art editor";
-static char args_doc[] = "[FILE]";
+static char args_doc[] = "[FILE...]";
 
 // our options
 static struct argp_option options[] = {
-	{"dimensions",  'd', 0, 0, "Show image dimensions"},
-	{"color", 'c', 0, 0,  "Produce colored output" },
+	{"dimensions",  'd', 0, 0, "Print FILE's dimensions and exit, without the editor"},
+	{"color", 'c', 0, 0,  "Print FILE as ANSI colored text and exit, without the editor" },
+	{"fps", 'f', "FPS", 0, "Maximum screen updates per second (0: no limit)"},
+	{"key-char", 'k', "CHAR", 0, "Transparent paste skips this char (default: blanks)"},
+	{"key-attr", 'a', "ATTR", 0, "Transparent paste skips this attribute"},
+	{"batch", 'b', "FORMAT", 0, "Convert every FILE (or the .mosi/.mosb files in a directory) to FORMAT: ansi, text, mosi (trimmed) or mosb (binary), and exit"},
+	{"output", 'o', "DIR", 0, "Batch outputs go in DIR (default: next to each FILE)"},
+	{"jobs", 'j', "N", 0, "Batch conversions run in N threads (default: one per CPU)"},
+	{"undo-memory", 'u', "KB", 0, "Memory cap for undo/redo, in KB"},
+	{"margin", 'm', "CELLS", 0, "Cells kept between the cursor and the screen borders when scrolling"},
+	{"autosave", 's', "SECONDS", 0, "Save recovery copies of the images every SECONDS while they change (0: never)"},
+	{"play-fps", 'p', "FPS", 0, "Playing the images as an animation (F5) shows FPS of them per second"},
+	{"journal", 'J', "KB", 0, "Saving a FILE again appends just the changes to FILE.journal, until it passes KB (0: always rewrite FILE)"},
 	{ 0 }
 };
 
-/* Used by arguments to communicate with parse_opt */
-struct arguments {
-	char *input;
-	char dimensions, color;
-};
+/* Which parts of the transparent key were given */
+static char key_char_given, key_attr_given;
 
 static error_t parse_opt (int key, char *arg, struct argp_state *state) {
 	struct arguments *argumentos = (struct arguments*) state->input;
@@ -32,12 +49,65 @@ static error_t parse_opt (int key, char *arg, struct argp_state *state) {
 		case 'd':
 			argumentos->dimensions = 1;
 			break;
+		case 'f':
+			argumentos->max_fps = atoi (arg);
+			break;
+		case 'k':
+			argumentos->transparent_key.ch = arg[0];
+			key_char_given = 1;
+			break;
+		case 'a':
+			argumentos->transparent_key.attr = atoi (arg);
+			key_attr_given = 1;
+			break;
+		case 'u':
+			argumentos->history_kb = atoi (arg);
+			break;
+		case 'm':
+			argumentos->scroll_margin = atoi (arg);
+			break;
+		case 's':
+			argumentos->autosave = atoi (arg);
+			break;
+		case 'p':
+			argumentos->play_fps = atoi (arg);
+			break;
+		case 'J':
+			argumentos->journal_kb = atoi (arg);
+			break;
+
+		case 'b':
+			argumentos->batch = BatchTargetNamed (arg);
+			if (argumentos->batch == BATCH_NONE) {
+				argp_error (state, "unknown batch format '%s'", arg);
+			}
+			break;
+		case 'o':
+			argumentos->output_dir = arg;
+			break;
+		case 'j':
+			argumentos->jobs = atoi (arg);
+			break;
 
-		case ARGP_KEY_ARG:
-			argumentos->input = arg;
+		// all the files at once, so batch mode gets them all
+		case ARGP_KEY_ARGS:
+			argumentos->inputs = state->argv + state->next;
+			argumentos->n_inputs = state->argc - state->next;
+			argumentos->input = argumentos->inputs[0];
 			break;
 
 		case ARGP_KEY_END:
+			if (argumentos->batch == BATCH_NONE && argumentos->n_inputs > 1) {
+				argp_error (state, "only one FILE, unless in batch mode");
+			}
+			if (argumentos->batch != BATCH_NONE && argumentos->n_inputs == 0) {
+				argp_error (state, "batch mode needs files or directories");
+			}
+			// key only by what was given; both (or none) is the whole cell
+			if (key_char_given != key_attr_given) {
+				argumentos->transparent_key.mode = key_char_given ?
+						BLIT_KEY_CH : BLIT_KEY_ATTR;
+			}
 			break;
 
 		default:
@@ -52,11 +122,22 @@ static error_t parse_opt (int key, char *arg, struct argp_state *state) {
 static struct argp argp = { options, parse_opt, args_doc, doc };
 
 
-const char *arguments (int argc, char *argv[]) {
-	struct arguments args;
-	args.input = NULL;
-	argp_parse (&argp, argc, argv, 0, 0, &args);
-
-	return args.input;
-
+void arguments (int argc, char *argv[], struct arguments *args) {
+	args->input = NULL;
+	args->inputs = NULL;
+	args->n_inputs = 0;
+	args->batch = BATCH_NONE;
+	args->output_dir = NULL;
+	args->jobs = 0;
+	args->dimensions = args->color = 0;
+	args->max_fps = DEFAULT_MAX_FPS;
+	args->transparent_key.mode = BLIT_KEY_CELL;
+	args->transparent_key.ch = ' ';
+	args->transparent_key.attr = Normal;
+	args->history_kb = DEFAULT_HISTORY_KB;
+	args->scroll_margin = DEFAULT_SCROLL_MARGIN;
+	args->autosave = DEFAULT_AUTOSAVE_INTERVAL;
+	args->journal_kb = DEFAULT_JOURNAL_KB;
+	args->play_fps = DEFAULT_PLAY_FPS;
+	argp_parse (&argp, argc, argv, 0, 0, args);
 }
@@ -0,0 +1,225 @@
+#include "async.h"
+#include "maae.h"
+
+#include <mosaic/stream_io.h>
+#include <pthread.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// The job, shared with the worker
+static struct {
+	AsyncKind kind;	///< what it is; ASYNC_IDLE if there's none
+	pthread_t worker;	///< the worker thread
+	char *file_name;	///< the file
+	CURS_MOS *target;	///< the image saved, or loaded to
+	MOSAIC *img;	///< the saved snapshot, or the loaded image
+	Canvas *canvas;	///< the saved snapshot, for canvases
+	char to_canvas;	///< is the target a canvas, when loading
+	char lazy;	///< loaded binary file to be mapped, not decoded here
+	int rows;	///< rows to be written; 0 if it can't be known
+	int rows_done;	///< rows written so far
+	int ret;	///< the job's return value
+	char done;	///< has the worker finished
+	pthread_mutex_t lock;	///< protects done and ret
+	pthread_cond_t finished;	///< signaled when done
+} job = {ASYNC_IDLE, .lock = PTHREAD_MUTEX_INITIALIZER,
+		.finished = PTHREAD_COND_INITIALIZER};
+
+
+/// Aux function: the worker's save
+static int WorkerSave () {
+	if (job.canvas) {
+		return SaveCanvas (job.canvas, job.file_name, &job.rows_done);
+	}
+	return BinaryName (job.file_name)
+			? SaveBinary (job.img, job.file_name, &job.rows_done)
+			: SaveMOSAIC (job.img, job.file_name);
+}
+
+
+/// Aux function: the worker's load
+static int WorkerLoad () {
+	if (!IsBinary (job.file_name)) {
+		return LoadAnyMOSAIC (job.img, job.file_name);
+	}
+
+	// big binary files (and any, for canvases) are mapped when the job is
+	// collected, as that's quick already
+	BinaryFile file;
+	int ret = OpenBinary (&file, job.file_name);
+	if (ret) {
+		return ret;
+	}
+	job.lazy = job.to_canvas || file.height > MAX_DENSE_SIDE
+			|| file.width > MAX_DENSE_SIDE;
+	CloseBinary (&file);
+
+	return job.lazy ? 0 : LoadAnyMOSAIC (job.img, job.file_name);
+}
+
+
+/// Aux function: the worker thread
+static void *Worker (void *arg) {
+	const int ret = job.kind == ASYNC_SAVE ? WorkerSave () : WorkerLoad ();
+
+	pthread_mutex_lock (&job.lock);
+	job.ret = ret;
+	job.done = 1;
+	pthread_cond_signal (&job.finished);
+	pthread_mutex_unlock (&job.lock);
+
+	return NULL;
+}
+
+
+/// Aux function: sets a job up; the worker is started by the caller, once
+/// everything is in place
+static void Prepare (AsyncKind kind, CURS_MOS *img, const char *file_name) {
+	job.kind = kind;
+	job.file_name = strdup (file_name);
+	job.target = img;
+	job.img = NULL;
+	job.canvas = NULL;
+	job.to_canvas = GetCanvas (img) != NULL;
+	job.lazy = 0;
+	job.rows = 0;
+	job.rows_done = 0;
+	job.ret = 0;
+	job.done = 0;
+}
+
+
+int StartSave (CURS_MOS *img, const char *file_name) {
+	if (job.kind != ASYNC_IDLE) {
+		return EBUSY;
+	}
+	Prepare (ASYNC_SAVE, img, file_name);
+	StartCheckpoint (img);
+
+	// the snapshot is taken here, so edits from now on don't reach the file
+	Canvas *canvas = GetCanvas (img);
+	if (canvas) {
+		// the worker reads bands still undecoded from the source, unless
+		// it's file is the one a text save truncates
+		job.canvas = SnapshotCanvas (canvas, !BinaryName (file_name)
+				&& OverwritesSource (img, file_name));
+	}
+	else {
+		job.img = NewMOSAIC (0, 0);
+		CopyMOSAIC (job.img, img->img);
+	}
+	// only binary files tell how far they are
+	if (BinaryName (file_name)) {
+		job.rows = canvas ? job.canvas->tiles->height : job.img->height;
+	}
+
+	pthread_create (&job.worker, NULL, Worker, NULL);
+	return 0;
+}
+
+
+int StartLoad (CURS_MOS *img, const char *file_name) {
+	if (job.kind != ASYNC_IDLE) {
+		return EBUSY;
+	}
+	Prepare (ASYNC_LOAD, img, file_name);
+	job.img = NewMOSAIC (0, 0);
+
+	pthread_create (&job.worker, NULL, Worker, NULL);
+	return 0;
+}
+
+
+AsyncKind AsyncRunning () {
+	return job.kind;
+}
+
+
+int AsyncProgress () {
+	if (job.rows <= 0) {
+		return -1;
+	}
+	return (int) (100LL * __atomic_load_n (&job.rows_done, __ATOMIC_RELAXED)
+			/ job.rows);
+}
+
+
+const char *AsyncFile () {
+	return job.file_name;
+}
+
+
+/// Aux function: puts the loaded file in the target
+static int PutLoaded () {
+	CURS_MOS *target = job.target;
+	Canvas *canvas = GetCanvas (target);
+	// binary files to map: the canvas takes them, or the target becomes one
+	if (job.lazy) {
+		return canvas ? LoadCanvas (canvas, job.file_name)
+				: LoadAnyCURS_MOS (target, job.file_name);
+	}
+
+	if (canvas) {
+		SetCanvasMOSAIC (canvas, job.img);
+	}
+	else {
+		BeginEdit (target, 0);
+		RecordImage (target);
+		ResizeCURS_MOS (target, job.img->height, job.img->width);
+		CopyMOSAIC (target->img, job.img);
+	}
+	ENTER_(REDRAW);
+
+	return job.ret;
+}
+
+
+int FinishAsync (AsyncKind *kind, CURS_MOS **target) {
+	if (job.kind == ASYNC_IDLE) {
+		return ERR;
+	}
+	pthread_mutex_lock (&job.lock);
+	const char done = job.done;
+	pthread_mutex_unlock (&job.lock);
+	if (!done) {
+		return ERR;
+	}
+	pthread_join (job.worker, NULL);
+
+	*kind = job.kind;
+	*target = job.target;
+	int ret = job.ret;
+	if (job.kind == ASYNC_LOAD && LoadedChars (ret)) {
+		ret = PutLoaded ();
+		if (LoadedChars (ret)) {
+			JournalAttach (job.target, job.file_name);
+		}
+	}
+	else if (job.kind == ASYNC_SAVE) {
+		EndCheckpoint (job.target, job.file_name, ret);
+	}
+
+	if (job.img) {
+		FreeMOSAIC (job.img);
+	}
+	if (job.canvas) {
+		FreeSnapshot (job.canvas);
+	}
+	free (job.file_name);
+	job.file_name = NULL;
+	job.kind = ASYNC_IDLE;
+
+	return ret;
+}
+
+
+void WaitAsync () {
+	if (job.kind != ASYNC_IDLE) {
+		pthread_mutex_lock (&job.lock);
+		while (!job.done) {
+			pthread_cond_wait (&job.finished, &job.lock);
+		}
+		pthread_mutex_unlock (&job.lock);
+	}
+}
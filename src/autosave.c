@@ -0,0 +1,401 @@
+#include "autosave.h"
+#include "maae.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/file.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/// How often to look for a running autosave's end, in milliseconds
+#define AUTOSAVE_POLL_MS 250
+
+/// A file left by a crashed session
+typedef struct {
+	int pid;	///< the session's PID
+	int n;	///< the image's position
+	char *path;	///< the file
+} Leftover;
+
+/// The autosaving state
+static struct {
+	int interval;	///< seconds between autosaves; 0 for none
+	struct timespec last;	///< when the last one started
+	unsigned long edits;	///< EditCount when the last one started
+	char pending;	///< save even without new edits (recovered, or failed)
+	pid_t child;	///< the child saving now; 0 if there's none
+	char **stale;	///< recovered files, removed when ours are saved
+	int n_stale;	///< how many stale files there are
+	int lock;	///< this session's lock file, locked while it runs; -1 if none
+} autosave = {DEFAULT_AUTOSAVE_INTERVAL, {0, 0}, 0, 0, 0, NULL, 0, -1};
+
+
+/**
+ * Aux function: the recovery directory, created if needed
+ *
+ * @return The directory, or NULL if there's no home to put it in
+ */
+static const char *RecoveryDir () {
+	static char dir[PATH_MAX] = "";
+	if (dir[0]) {
+		return dir;
+	}
+
+	const char *state_home = getenv ("XDG_STATE_HOME");
+	const char *home = getenv ("HOME");
+	if (state_home && state_home[0]) {
+		snprintf (dir, sizeof (dir), "%s/maae", state_home);
+	}
+	else if (home && home[0]) {
+		snprintf (dir, sizeof (dir), "%s/.local/state/maae", home);
+	}
+	else {
+		return NULL;
+	}
+
+	// mkdir -p
+	char *slash;
+	for (slash = strchr (dir + 1, '/'); slash; slash = strchr (slash + 1, '/')) {
+		*slash = '\0';
+		mkdir (dir, 0700);
+		*slash = '/';
+	}
+	if (mkdir (dir, 0700) && errno != EEXIST) {
+		dir[0] = '\0';
+		return NULL;
+	}
+	return dir;
+}
+
+
+/// Aux function: the lock file of session, in dir
+static void LockName (char *path, size_t size, const char *dir, int session) {
+	snprintf (path, size, "%s/%d.lock", dir, session);
+}
+
+
+/// Aux function: takes this session's lock, held until it ends (or
+/// crashes), before it's first files are written
+static void Lock (const char *dir) {
+	if (autosave.lock >= 0) {
+		return;
+	}
+	char path[PATH_MAX];
+	LockName (path, sizeof (path), dir, (int) getpid ());
+	const int fd = open (path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+	if (fd >= 0 && flock (fd, LOCK_EX | LOCK_NB) == 0) {
+		autosave.lock = fd;
+	}
+	else if (fd >= 0) {
+		close (fd);
+	}
+}
+
+
+/**
+ * Aux function: is session still running? It holds it's lock while it
+ * does, whatever process gets it's PID after it's gone
+ */
+static int Running (const char *dir, int session) {
+	char path[PATH_MAX];
+	LockName (path, sizeof (path), dir, session);
+	const int fd = open (path, O_RDWR | O_CLOEXEC);
+	if (fd < 0) {
+		return 0;
+	}
+	// a lock of our own is let go when fd is closed
+	const int running = flock (fd, LOCK_EX | LOCK_NB) != 0;
+	close (fd);
+	return running;
+}
+
+
+/// Aux function: removes a crashed session's file, and it's lock
+static void RemoveLeftover (const char *path) {
+	remove (path);
+	const char *dir = RecoveryDir ();
+	const char *name = strrchr (path, '/');
+	int session;
+	if (dir && name && sscanf (name + 1, "%d-", &session) == 1) {
+		char lock[PATH_MAX];
+		LockName (lock, sizeof (lock), dir, session);
+		remove (lock);
+	}
+}
+
+
+/// Aux function: milliseconds since the last autosave started
+static long SinceLastAutosave () {
+	struct timespec now;
+	clock_gettime (CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - autosave.last.tv_sec) * 1000
+			+ (now.tv_nsec - autosave.last.tv_nsec) / 1000000;
+}
+
+
+/// Aux function: is there something the last autosave doesn't have?
+static int Changed () {
+	return autosave.pending || EditCount () != autosave.edits;
+}
+
+
+void SetAutosaveInterval (int seconds) {
+	autosave.interval = seconds > 0 ? seconds : 0;
+	autosave.edits = EditCount ();
+	clock_gettime (CLOCK_MONOTONIC, &autosave.last);
+}
+
+
+int AutosaveWait () {
+	if (autosave.child) {
+		return AUTOSAVE_POLL_MS;
+	}
+	if (!autosave.interval || !Changed () || !RecoveryDir ()) {
+		return -1;
+	}
+	const long wait = autosave.interval * 1000L - SinceLastAutosave ();
+	// due, but put off while a file is loaded or saved (see Autosave)
+	if (wait <= 0 && AsyncRunning ()) {
+		return AUTOSAVE_POLL_MS;
+	}
+	return wait > 0 ? (int) wait : 0;
+}
+
+
+/// Aux function: the child's work, saving every image as session's
+static int SaveAll (IMGS *everyone, const char *dir, pid_t session) {
+	char path[PATH_MAX];
+	int n, failed = 0;
+	for (n = 0; n < everyone->size; n++) {
+		CURS_MOS *img = GoToPage (everyone, n);
+		snprintf (path, sizeof (path), "%s/%d-%d.mosb", dir, (int) session, n);
+		Canvas *canvas = GetCanvas (img);
+		failed |= canvas ? SaveCanvas (canvas, path, NULL)
+				: SaveBinary (img->img, path, NULL);
+	}
+
+	return failed != 0;
+}
+
+
+/// Aux function: removes the recovered files, now that ours are there
+static void RemoveStale () {
+	int i;
+	for (i = 0; i < autosave.n_stale; i++) {
+		RemoveLeftover (autosave.stale[i]);
+		free (autosave.stale[i]);
+	}
+	free (autosave.stale);
+	autosave.stale = NULL;
+	autosave.n_stale = 0;
+}
+
+
+int Autosave (IMGS *everyone) {
+	int ret = ERR;
+	// the last one may be done
+	if (autosave.child) {
+		int status;
+		if (waitpid (autosave.child, &status, WNOHANG) != autosave.child) {
+			return ERR;
+		}
+		autosave.child = 0;
+		ret = WIFEXITED (status) && WEXITSTATUS (status) == 0 ? 0 : EIO;
+		if (ret == 0) {
+			RemoveStale ();
+		}
+		else {
+			autosave.pending = 1;
+		}
+	}
+
+	const char *dir = RecoveryDir ();
+	if (!autosave.interval || !dir || !everyone->list || !Changed ()
+			|| SinceLastAutosave () < autosave.interval * 1000L) {
+		return ret;
+	}
+	// the child would get a copy of the file thread's locks, but not the
+	// thread to let go of them: put it off until the thread is done
+	if (AsyncRunning ()) {
+		return ret;
+	}
+
+	autosave.edits = EditCount ();
+	autosave.pending = 0;
+	clock_gettime (CLOCK_MONOTONIC, &autosave.last);
+	Lock (dir);
+	// the child gets a copy-on-write snapshot of everything, for free
+	const pid_t session = getpid ();
+	pid_t pid = fork ();
+	if (pid == 0) {
+		// the editor comes first
+		setpriority (PRIO_PROCESS, 0, 10);
+		_exit (SaveAll (everyone, dir, session));
+	}
+	else if (pid < 0) {
+		autosave.pending = 1;
+		return errno;
+	}
+	autosave.child = pid;
+
+	return ret;
+}
+
+
+/// Aux function: scandir filter for autosaved files
+static int IsAutosave (const struct dirent *entry) {
+	int pid, n, end = 0;
+	return sscanf (entry->d_name, "%d-%d.mosb%n", &pid, &n, &end) == 2
+			&& end > 0 && entry->d_name[end] == '\0';
+}
+
+
+/// Aux function: qsort comparison, by session and then position
+static int CompareLeftovers (const void *a, const void *b) {
+	const Leftover *x = (const Leftover *) a, *y = (const Leftover *) b;
+	return x->pid != y->pid ? (x->pid > y->pid) - (x->pid < y->pid)
+			: (x->n > y->n) - (x->n < y->n);
+}
+
+
+/**
+ * Aux function: lists the files left by sessions not running anymore
+ *
+ * @return How many there are; free each path, and the list
+ */
+static int FindLeftovers (Leftover **found) {
+	*found = NULL;
+	const char *dir = RecoveryDir ();
+	struct dirent **entries;
+	const int n_entries = dir ? scandir (dir, &entries, IsAutosave, NULL) : -1;
+	if (n_entries < 0) {
+		return 0;
+	}
+
+	*found = (Leftover *) malloc ((n_entries + 1) * sizeof (Leftover));
+	int i, n = 0;
+	for (i = 0; i < n_entries; i++) {
+		Leftover *left = &(*found)[n];
+		sscanf (entries[i]->d_name, "%d-%d", &left->pid, &left->n);
+		// a session still running isn't crashed
+		if (left->pid == getpid () || Running (dir, left->pid)) {
+			free (entries[i]);
+			continue;
+		}
+		left->path = (char *) malloc (strlen (dir) + strlen (entries[i]->d_name) + 2);
+		sprintf (left->path, "%s/%s", dir, entries[i]->d_name);
+		free (entries[i]);
+		n++;
+	}
+	free (entries);
+
+	qsort (*found, n, sizeof (Leftover), CompareLeftovers);
+	return n;
+}
+
+
+int RecoverableImages () {
+	Leftover *found;
+	const int n = FindLeftovers (&found);
+	int i;
+	for (i = 0; i < n; i++) {
+		free (found[i].path);
+	}
+	free (found);
+
+	return n;
+}
+
+
+CURS_MOS *RecoverImages (IMGS *everyone, CURS_MOS *current) {
+	Leftover *found;
+	const int n = FindLeftovers (&found);
+	CURS_MOS *first = NULL;
+	int i;
+	for (i = 0; i < n; i++) {
+		CURS_MOS *img = NewCURS_MOS (0, 0);
+		const int ret = LoadAnyCURS_MOS (img, found[i].path);
+		if (!LoadedChars (ret)) {
+			FreeCURS_MOS (img);
+			free (found[i].path);
+			continue;
+		}
+
+		AddPage (everyone, current, img, after);
+		current = img;
+		if (!first) {
+			first = img;
+		}
+
+		// kept until our own autosave has them
+		autosave.stale = (char **) realloc (autosave.stale,
+				(autosave.n_stale + 1) * sizeof (char *));
+		autosave.stale[autosave.n_stale++] = found[i].path;
+	}
+	free (found);
+
+	// right away, so they're in our files as soon as possible
+	if (first) {
+		autosave.pending = 1;
+		autosave.last.tv_sec -= autosave.interval;
+	}
+	return first;
+}
+
+
+void DiscardRecovery () {
+	Leftover *found;
+	const int n = FindLeftovers (&found);
+	int i;
+	for (i = 0; i < n; i++) {
+		RemoveLeftover (found[i].path);
+		free (found[i].path);
+	}
+	free (found);
+}
+
+
+void EndAutosave () {
+	if (autosave.child) {
+		kill (autosave.child, SIGKILL);
+		waitpid (autosave.child, NULL, 0);
+		autosave.child = 0;
+	}
+	RemoveStale ();
+
+	// our files, and whatever temporary one the child left
+	const char *dir = RecoveryDir ();
+	struct dirent **entries;
+	const int n = dir ? scandir (dir, &entries, NULL, NULL) : -1;
+	char prefix[32], path[PATH_MAX];
+	snprintf (prefix, sizeof (prefix), "%d-", (int) getpid ());
+	int i;
+	for (i = 0; i < n; i++) {
+		if (!strncmp (entries[i]->d_name, prefix, strlen (prefix))) {
+			snprintf (path, sizeof (path), "%s/%s", dir, entries[i]->d_name);
+			remove (path);
+		}
+		free (entries[i]);
+	}
+	if (n >= 0) {
+		free (entries);
+	}
+
+	// nothing is left to be recovered from us
+	if (autosave.lock >= 0) {
+		LockName (path, sizeof (path), dir, (int) getpid ());
+		remove (path);
+		close (autosave.lock);
+		autosave.lock = -1;
+	}
+}
@@ -0,0 +1,277 @@
+#include "batch.h"
+#include "export.h"
+#include "binary.h"
+
+#include <mosaic/stream_io.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// The targets' names, for the command line
+static const char *target_names[] = {NULL, "ansi", "text", "mosi", "mosb"};
+/// The outputs' extensions, by target
+static const char *extensions[] = {NULL, ".ans", ".txt", ".mosi", ".mosb"};
+
+/// A file to convert, and how it went
+typedef struct {
+	char *input;	///< the .mosi (or .mosb) file
+	char *output;	///< the converted file
+	const char *stage;	///< what went wrong ("load", "write"...); NULL if nothing
+	int err;	///< the error, in stage
+	char warning;	///< converted, but without the attributes
+	int clash;	///< index of an earlier job with the same output; -1 if none
+} Job;
+
+/// The jobs, shared by the workers
+static struct {
+	Job *jobs;	///< every job, in the inputs' order
+	int size;	///< how many jobs there are
+	int capacity;	///< how many fit in jobs
+	int next;	///< next job to be taken by a worker
+	BatchTarget target;	///< what they're converted to
+	pthread_mutex_t lock;	///< protects next
+} batch;
+
+
+BatchTarget BatchTargetNamed (const char *name) {
+	BatchTarget target;
+	for (target = BATCH_ANSI; target <= BATCH_MOSB; target++) {
+		if (!strcmp (name, target_names[target])) {
+			return target;
+		}
+	}
+
+	return BATCH_NONE;
+}
+
+
+/// Aux function: the output path for input
+static char *OutputPath (const char *input, const char *output_dir) {
+	const char *slash = strrchr (input, '/');
+	const char *base = slash ? slash + 1 : input;
+	// the base name, without the .mosi
+	size_t base_len = strlen (base);
+	const char *dot = strrchr (base, '.');
+	if (dot && (!strcmp (dot, ".mosi") || BinaryName (base))) {
+		base_len = dot - base;
+	}
+
+	// no output directory: next to the input
+	const char *dir = output_dir;
+	size_t dir_len = dir ? strlen (dir) : 0;
+	if (!dir) {
+		dir = slash ? input : ".";
+		dir_len = slash ? (size_t) (slash - input) : 1;
+	}
+
+	const char *ext = extensions[batch.target];
+	char *path = (char *) malloc (dir_len + base_len + strlen (ext) + 2);
+	sprintf (path, "%.*s/%.*s%s", (int) dir_len, dir, (int) base_len, base, ext);
+
+	return path;
+}
+
+
+/// Aux function: adds a job for input
+static void AddJob (const char *input, const char *output_dir) {
+	if (batch.size == batch.capacity) {
+		batch.capacity = batch.capacity ? batch.capacity * 2 : 64;
+		batch.jobs = (Job *) realloc (batch.jobs, batch.capacity * sizeof (Job));
+	}
+
+	Job *job = &batch.jobs[batch.size++];
+	job->input = strdup (input);
+	job->output = OutputPath (input, output_dir);
+	job->stage = NULL;
+	job->err = 0;
+	job->warning = 0;
+	job->clash = -1;
+}
+
+
+/// Aux function: scandir filter for .mosi and .mosb files
+static int IsMosi (const struct dirent *entry) {
+	const char *dot = strrchr (entry->d_name, '.');
+	return dot && (!strcmp (dot, ".mosi") || BinaryName (dot));
+}
+
+
+/// Aux function: adds the jobs for an input, the files in it if it's a directory
+static void AddInput (const char *input, const char *output_dir) {
+	struct stat info;
+	struct dirent **entries;
+	int i, n;
+
+	if (stat (input, &info) || !S_ISDIR (info.st_mode)
+			|| (n = scandir (input, &entries, IsMosi, alphasort)) < 0) {
+		// not a directory (or not there): Convert will tell
+		AddJob (input, output_dir);
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+		char *path = (char *) malloc (strlen (input) + strlen (entries[i]->d_name) + 2);
+		sprintf (path, "%s/%s", input, entries[i]->d_name);
+		AddJob (path, output_dir);
+		free (path);
+		free (entries[i]);
+	}
+	free (entries);
+}
+
+
+/// Aux function: qsort comparison of jobs (by pointer) by output, then order
+static int CompareOutputs (const void *a, const void *b) {
+	const Job *x = *(const Job **) a, *y = *(const Job **) b;
+	int cmp = strcmp (x->output, y->output);
+	return cmp ? cmp : (x > y) - (x < y);
+}
+
+
+/// Aux function: jobs with an output an earlier one has can't run
+static void FindClashes () {
+	Job **sorted = (Job **) malloc (batch.size * sizeof (Job *));
+	int i;
+	for (i = 0; i < batch.size; i++) {
+		sorted[i] = &batch.jobs[i];
+	}
+	qsort (sorted, batch.size, sizeof (Job *), CompareOutputs);
+
+	for (i = 1; i < batch.size; i++) {
+		if (!strcmp (sorted[i]->output, sorted[i - 1]->output)) {
+			// the first of them is the one that runs
+			sorted[i]->clash = sorted[i - 1]->clash >= 0 ?
+					sorted[i - 1]->clash : sorted[i - 1] - batch.jobs;
+		}
+	}
+	free (sorted);
+}
+
+
+/// Aux function: converts a file
+static void Convert (Job *job) {
+	MOSAIC *img = NewMOSAIC (0, 0);
+	int ret = LoadAnyMOSAIC (img, job->input);
+
+	if (!LoadedChars (ret)) {
+		job->stage = "load";
+		job->err = ret;
+	}
+	else if (ret) {
+		job->warning = 1;
+	}
+
+	if (!job->stage && (batch.target == BATCH_MOSI || batch.target == BATCH_MOSB)) {
+		if (batch.target == BATCH_MOSI) {
+			TrimMOSAIC (img, 1);
+			ret = SaveMOSAIC (img, job->output);
+		}
+		else {
+			ret = SaveBinary (img, job->output, NULL);
+		}
+		if (ret) {
+			job->stage = "save";
+			job->err = ret;
+		}
+	}
+	else if (!job->stage) {
+		FILE *out = fopen (job->output, "w");
+		if (!out) {
+			job->stage = "open";
+			job->err = errno;
+		}
+		else {
+			ret = batch.target == BATCH_ANSI ?
+					ExportANSI (img, out) : ExportText (img, out);
+			if (fclose (out) && !ret) {
+				ret = errno;
+			}
+			if (ret) {
+				job->stage = "write";
+				job->err = ret;
+			}
+		}
+	}
+
+	FreeMOSAIC (img);
+}
+
+
+/// Aux function: a worker takes the next job until there's none
+static void *Worker (void *arg) {
+	while (1) {
+		pthread_mutex_lock (&batch.lock);
+		const int i = batch.next++;
+		pthread_mutex_unlock (&batch.lock);
+
+		if (i >= batch.size) {
+			return NULL;
+		}
+		if (batch.jobs[i].clash < 0) {
+			Convert (&batch.jobs[i]);
+		}
+	}
+}
+
+
+int Batch (BatchTarget target, char **inputs, int n_inputs,
+		const char *output_dir, int jobs) {
+	batch.target = target;
+	batch.next = 0;
+	pthread_mutex_init (&batch.lock, NULL);
+
+	int i;
+	for (i = 0; i < n_inputs; i++) {
+		AddInput (inputs[i], output_dir);
+	}
+	FindClashes ();
+
+	// the pool: no more workers than jobs
+	if (jobs <= 0) {
+		jobs = sysconf (_SC_NPROCESSORS_ONLN);
+	}
+	jobs = jobs < batch.size ? jobs : batch.size;
+	jobs = jobs > 0 ? jobs : 1;
+	pthread_t *workers = (pthread_t *) malloc (jobs * sizeof (pthread_t));
+	for (i = 0; i < jobs; i++) {
+		pthread_create (&workers[i], NULL, Worker, NULL);
+	}
+	for (i = 0; i < jobs; i++) {
+		pthread_join (workers[i], NULL);
+	}
+	free (workers);
+
+	// the report, in the inputs' order
+	int failed = 0;
+	for (i = 0; i < batch.size; i++) {
+		Job *job = &batch.jobs[i];
+		if (job->clash >= 0) {
+			fprintf (stderr, "%s: skipped, same output as %s\n", job->input,
+					batch.jobs[job->clash].input);
+			failed++;
+		}
+		else if (job->stage) {
+			fprintf (stderr, "%s: %s: %s\n", job->input, job->stage,
+					LoadError (job->err));
+			failed++;
+		}
+		else {
+			fprintf (stderr, "%s -> %s%s\n", job->input, job->output,
+					job->warning ? " (no attributes)" : "");
+		}
+	}
+	fprintf (stderr, "%d converted, %d failed\n", batch.size - failed, failed);
+
+	for (i = 0; i < batch.size; i++) {
+		free (batch.jobs[i].input);
+		free (batch.jobs[i].output);
+	}
+	free (batch.jobs);
+	pthread_mutex_destroy (&batch.lock);
+
+	return failed ? 1 : 0;
+}
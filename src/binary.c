@@ -0,0 +1,364 @@
+#include "binary.h"
+#include "canvas.h"
+#include "journal.h"
+
+#include <mosaic/stream_io.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Bytes before the row index
+#define HEADER_SIZE 16
+/// Bytes per char, in the file
+#define CHAR_SIZE 1
+/// Bytes per attribute, in the file
+#define ATTR_SIZE 4
+/// Longest run (or literal sequence) a control byte holds
+#define MAX_RUN 128
+/// Appended to the name of the file being saved, until it's complete
+#define TEMP_SUFFIX ".part"
+
+
+/// Aux function: writes value's size low bytes, little-endian
+static void PutValue (unsigned char *out, uint64_t value, int size) {
+	int i;
+	for (i = 0; i < size; i++) {
+		out[i] = (value >> (8 * i)) & 0xff;
+	}
+}
+
+
+/// Aux function: reads a size bytes little-endian value
+static uint64_t GetValue (const unsigned char *in, int size) {
+	uint64_t value = 0;
+	int i;
+	for (i = size - 1; i >= 0; i--) {
+		value = (value << 8) | in[i];
+	}
+	return value;
+}
+
+
+size_t PackValues (const uint32_t *vals, int n, int size, unsigned char *out) {
+	size_t len = 0;
+	int i = 0, k;
+	while (i < n) {
+		int run = 1;
+		while (i + run < n && run < MAX_RUN && vals[i + run] == vals[i]) {
+			run++;
+		}
+
+		if (run > 1) {
+			out[len++] = 257 - run;
+			PutValue (out + len, vals[i], size);
+			len += size;
+		}
+		// literals, until a run starts
+		else {
+			while (i + run < n && run < MAX_RUN
+					&& !(i + run + 1 < n && vals[i + run] == vals[i + run + 1])) {
+				run++;
+			}
+			out[len++] = run - 1;
+			for (k = 0; k < run; k++, len += size) {
+				PutValue (out + len, vals[i + k], size);
+			}
+		}
+		i += run;
+	}
+
+	return len;
+}
+
+
+size_t UnpackValues (const unsigned char *in, size_t len, int n, int size,
+		uint32_t *vals) {
+	size_t p = 0;
+	int i = 0, count;
+	while (i < n) {
+		if (p >= len) {
+			return 0;
+		}
+		const unsigned int c = in[p++];
+		// 128 is a no-op
+		if (c == 128) {
+			continue;
+		}
+		count = c < 128 ? c + 1 : 257 - c;
+		const size_t bytes = c < 128 ? (size_t) count * size : (size_t) size;
+		if (count > n - i || bytes > len - p) {
+			return 0;
+		}
+
+		if (c < 128) {
+			for ( ; count; count--, p += size) {
+				vals[i++] = GetValue (in + p, size);
+			}
+		}
+		else {
+			const uint32_t value = GetValue (in + p, size);
+			for ( ; count; count--) {
+				vals[i++] = value;
+			}
+			p += size;
+		}
+	}
+
+	return p;
+}
+
+
+int IsBinary (const char *file_name) {
+	char magic[4];
+	FILE *f = fopen (file_name, "rb");
+	if (!f) {
+		return 0;
+	}
+	const int ret = fread (magic, 1, 4, f) == 4 && !memcmp (magic, "MOSB", 4);
+	fclose (f);
+
+	return ret;
+}
+
+
+int BinaryName (const char *file_name) {
+	const char *dot = strrchr (file_name, '.');
+	return dot && !strcmp (dot, BINARY_EXTENSION);
+}
+
+
+/// Aux function: row y's data offset, from the index
+static uint64_t RowOffset (BinaryFile *file, int y) {
+	return GetValue (file->data + HEADER_SIZE + 8 * (size_t) y, 8);
+}
+
+
+int OpenBinary (BinaryFile *file, const char *file_name) {
+	int fd = open (file_name, O_RDONLY);
+	if (fd < 0) {
+		return errno;
+	}
+	struct stat info;
+	if (fstat (fd, &info)) {
+		const int err = errno;
+		close (fd);
+		return err;
+	}
+	file->size = info.st_size;
+	if (file->size < HEADER_SIZE) {
+		close (fd);
+		return ENODIMENSIONS;
+	}
+	void *data = mmap (NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// the mapping stays valid without the descriptor
+	close (fd);
+	if (data == MAP_FAILED) {
+		return errno;
+	}
+	file->data = (const unsigned char *) data;
+
+	// the header: magic and the sizes we know how to read
+	if (memcmp (file->data, "MOSB", 4)) {
+		CloseBinary (file);
+		return ENODIMENSIONS;
+	}
+	file->height = GetValue (file->data + 8, 4);
+	file->width = GetValue (file->data + 12, 4);
+	if (file->data[4] != BINARY_VERSION || file->data[5] != CHAR_SIZE
+			|| file->data[6] != ATTR_SIZE || file->height < 0 || file->width < 0
+			|| file->height > MAX_CANVAS_SIDE || file->width > MAX_CANVAS_SIDE
+			|| (file->size - HEADER_SIZE) / 8 < (size_t) file->height + 1) {
+		CloseBinary (file);
+		return EBADMSG;
+	}
+
+	// the index must go forward, and stay in the file
+	int y;
+	for (y = 0; y <= file->height; y++) {
+		const uint64_t offset = RowOffset (file, y);
+		if (offset > file->size
+				|| (y > 0 && offset < RowOffset (file, y - 1))) {
+			CloseBinary (file);
+			return EBADMSG;
+		}
+	}
+
+	return 0;
+}
+
+
+int ReadBinaryRow (BinaryFile *file, int y, mos_char *chars, mos_attr *attrs) {
+	const uint64_t begin = RowOffset (file, y);
+	const size_t len = RowOffset (file, y + 1) - begin;
+	const unsigned char *row = file->data + begin;
+	uint32_t *vals = (uint32_t *) malloc (((size_t) file->width + 1)
+			* sizeof (uint32_t));
+	if (!vals) {
+		return ENOMEM;
+	}
+
+	// chars first, then the attributes right after them
+	int x, ret = EBADMSG;
+	size_t used = UnpackValues (row, len, file->width, CHAR_SIZE, vals);
+	if (used || file->width == 0) {
+		for (x = 0; x < file->width; x++) {
+			chars[x] = vals[x];
+		}
+		if (UnpackValues (row + used, len - used, file->width, ATTR_SIZE, vals)
+				|| file->width == 0) {
+			for (x = 0; x < file->width; x++) {
+				attrs[x] = vals[x];
+			}
+			ret = 0;
+		}
+	}
+
+	free (vals);
+	return ret;
+}
+
+
+void CloseBinary (BinaryFile *file) {
+	munmap ((void *) file->data, file->size);
+}
+
+
+int LoadBinary (MOSAIC *img, const char *file_name) {
+	BinaryFile file;
+	int ret = OpenBinary (&file, file_name);
+	if (ret) {
+		return ret;
+	}
+
+	ResizeMOSAIC (img, file.height, file.width);
+	int y;
+	for (y = 0; y < file.height && !ret; y++) {
+		ret = ReadBinaryRow (&file, y, img->mosaic + (size_t) y * img->width,
+				img->attr + (size_t) y * img->width);
+	}
+	CloseBinary (&file);
+
+	return ret;
+}
+
+
+int LoadAnyMOSAIC (MOSAIC *img, const char *file_name) {
+	const int ret = IsBinary (file_name) ? LoadBinary (img, file_name)
+			: LoadMOSAIC (img, file_name);
+	if (LoadedChars (ret)) {
+		ReplayJournal (file_name, img);
+	}
+	return ret;
+}
+
+
+/// Aux function: RowSource for a whole MOSAIC
+static void MOSAICRow (void *data, int y, mos_char *chars, mos_attr *attrs) {
+	MOSAIC *img = (MOSAIC *) data;
+	memcpy (chars, img->mosaic + (size_t) y * img->width,
+			img->width * sizeof (mos_char));
+	memcpy (attrs, img->attr + (size_t) y * img->width,
+			img->width * sizeof (mos_attr));
+}
+
+
+int SaveBinary (MOSAIC *img, const char *file_name, int *rows_done) {
+	return SaveBinaryRows (img->height, img->width, MOSAICRow, img, file_name,
+			rows_done);
+}
+
+
+int SaveBinaryRows (int height, int width, RowSource source, void *data,
+		const char *file_name, int *rows_done) {
+	// the index, filled as rows are written, and a row's buffers
+	const size_t index_size = 8 * ((size_t) height + 1);
+	unsigned char *index = (unsigned char *) calloc (index_size, 1);
+	mos_char *chars = (mos_char *) malloc (((size_t) width + 1) * sizeof (mos_char));
+	mos_attr *attrs = (mos_attr *) malloc (((size_t) width + 1) * sizeof (mos_attr));
+	uint32_t *vals = (uint32_t *) malloc (((size_t) width + 1) * sizeof (uint32_t));
+	unsigned char *packed = (unsigned char *) malloc ((size_t) width * (ATTR_SIZE + 1) + 1);
+	// written aside and renamed over, as the file may be mapped (and being
+	// read by source) right now
+	char *temp_name = (char *) malloc (strlen (file_name) + sizeof (TEMP_SUFFIX));
+	FILE *f = NULL;
+	int ret = ENOMEM;
+	if (index && chars && attrs && vals && packed && temp_name) {
+		strcpy (temp_name, file_name);
+		strcat (temp_name, TEMP_SUFFIX);
+		f = fopen (temp_name, "wb");
+		ret = f ? 0 : errno;
+	}
+	if (!f) {
+		free (chars);
+		free (attrs);
+		free (vals);
+		free (packed);
+		free (index);
+		free (temp_name);
+		return ret;
+	}
+
+	unsigned char header[HEADER_SIZE] = {'M', 'O', 'S', 'B', BINARY_VERSION,
+			CHAR_SIZE, ATTR_SIZE, 0};
+	PutValue (header + 8, height, 4);
+	PutValue (header + 12, width, 4);
+	fwrite (header, 1, HEADER_SIZE, f);
+	fwrite (index, 1, index_size, f);
+
+	uint64_t offset = HEADER_SIZE + index_size;
+	int y, x;
+	for (y = 0; y < height; y++) {
+		PutValue (index + 8 * (size_t) y, offset, 8);
+		source (data, y, chars, attrs);
+
+		for (x = 0; x < width; x++) {
+			vals[x] = (unsigned char) chars[x];
+		}
+		size_t len = PackValues (vals, width, CHAR_SIZE, packed);
+		fwrite (packed, 1, len, f);
+		offset += len;
+
+		for (x = 0; x < width; x++) {
+			vals[x] = attrs[x];
+		}
+		len = PackValues (vals, width, ATTR_SIZE, packed);
+		fwrite (packed, 1, len, f);
+		offset += len;
+
+		// read by another thread, for the progress
+		if (rows_done) {
+			__atomic_store_n (rows_done, y + 1, __ATOMIC_RELAXED);
+		}
+	}
+	PutValue (index + 8 * (size_t) height, offset, 8);
+
+	// now the index is complete
+	fseek (f, HEADER_SIZE, SEEK_SET);
+	fwrite (index, 1, index_size, f);
+
+	free (chars);
+	free (attrs);
+	free (vals);
+	free (packed);
+	free (index);
+
+	ret = ferror (f) ? (errno ? errno : EIO) : 0;
+	if (fclose (f) && !ret) {
+		ret = errno;
+	}
+	if (!ret && rename (temp_name, file_name)) {
+		ret = errno;
+	}
+	if (ret) {
+		remove (temp_name);
+	}
+	free (temp_name);
+
+	return ret;
+}
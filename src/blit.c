@@ -0,0 +1,102 @@
+#include "blit.h"
+#include "cells.h"
+
+#include <string.h>
+
+/// A blit kernel: writes n cells of a row span
+typedef void (*BlitKernel) (mos_char *dst_chars, mos_attr *dst_attrs,
+		const mos_char *chars, const mos_attr *attrs, int n, BlitKey key);
+
+
+/// Opaque kernel: just copy it
+static void BlitOpaque (mos_char *dst_chars, mos_attr *dst_attrs,
+		const mos_char *chars, const mos_attr *attrs, int n, BlitKey key) {
+	memcpy (dst_chars, chars, n * sizeof (mos_char));
+	memcpy (dst_attrs, attrs, n * sizeof (mos_attr));
+}
+
+
+/*
+ * Keyed kernels: the mask is all ones where the source cell is opaque
+ * and all zeros where it's transparent, so both arrays are blended
+ * without branching
+ */
+#define BLEND(dst, src, mask, type) \
+	((type) (((src) & (mask)) | ((dst) & ~(mask))))
+
+static void BlitKeyCh (mos_char *dst_chars, mos_attr *dst_attrs,
+		const mos_char *chars, const mos_attr *attrs, int n, BlitKey key) {
+	int i;
+	for (i = 0; i < n; i++) {
+		const int opaque = chars[i] != key.ch;
+		const mos_char ch_mask = (mos_char) -opaque;
+		const mos_attr attr_mask = (mos_attr) -opaque;
+		dst_chars[i] = BLEND (dst_chars[i], chars[i], ch_mask, mos_char);
+		dst_attrs[i] = BLEND (dst_attrs[i], attrs[i], attr_mask, mos_attr);
+	}
+}
+
+
+static void BlitKeyAttr (mos_char *dst_chars, mos_attr *dst_attrs,
+		const mos_char *chars, const mos_attr *attrs, int n, BlitKey key) {
+	int i;
+	for (i = 0; i < n; i++) {
+		const int opaque = attrs[i] != key.attr;
+		const mos_char ch_mask = (mos_char) -opaque;
+		const mos_attr attr_mask = (mos_attr) -opaque;
+		dst_chars[i] = BLEND (dst_chars[i], chars[i], ch_mask, mos_char);
+		dst_attrs[i] = BLEND (dst_attrs[i], attrs[i], attr_mask, mos_attr);
+	}
+}
+
+
+static void BlitKeyCell (mos_char *dst_chars, mos_attr *dst_attrs,
+		const mos_char *chars, const mos_attr *attrs, int n, BlitKey key) {
+	int i;
+	for (i = 0; i < n; i++) {
+		const int opaque = (chars[i] != key.ch) | (attrs[i] != key.attr);
+		const mos_char ch_mask = (mos_char) -opaque;
+		const mos_attr attr_mask = (mos_attr) -opaque;
+		dst_chars[i] = BLEND (dst_chars[i], chars[i], ch_mask, mos_char);
+		dst_attrs[i] = BLEND (dst_attrs[i], attrs[i], attr_mask, mos_attr);
+	}
+}
+
+
+Rect Blit (MOSAIC *img, int y, int x, BlitSource src, BlitKey key) {
+	Rect written;
+
+	// clip it up front: skip source rows/columns outside img...
+	int skip_y = y < 0 ? -y : 0;
+	int skip_x = x < 0 ? -x : 0;
+	written.ULy = y + skip_y;
+	written.ULx = x + skip_x;
+	// ...in both ends
+	written.BRy = min (y + src.height - 1, img->height - 1);
+	written.BRx = min (x + src.width - 1, img->width - 1);
+	if (written.ULy > written.BRy || written.ULx > written.BRx) {
+		written.ULy = 1;
+		written.BRy = 0;
+		return written;
+	}
+
+	// choose the kernel once, not per cell
+	BlitKernel kernel;
+	switch (key.mode) {
+		case BLIT_KEY_CH:	kernel = BlitKeyCh;		break;
+		case BLIT_KEY_ATTR:	kernel = BlitKeyAttr;	break;
+		case BLIT_KEY_CELL:	kernel = BlitKeyCell;	break;
+		default:			kernel = BlitOpaque;	break;
+	}
+
+	const int n = written.BRx - written.ULx + 1;
+	int i;
+	for (i = written.ULy; i <= written.BRy; i++) {
+		const int from = (i - y) * src.stride + skip_x;
+		const int to = MOS_INDEX (img, i, written.ULx);
+		kernel (img->mosaic + to, img->attr + to,
+				src.chars + from, src.attrs + from, n, key);
+	}
+
+	return written;
+}
@@ -0,0 +1,690 @@
+#include "canvas.h"
+#include "positioning.h"
+#include "history.h"
+#include "binary.h"
+#include "journal.h"
+#include "blit.h"
+#include "cells.h"
+
+#include <mosaic/stream_io.h>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Every canvas there is
+static Canvas *canvases = NULL;
+
+
+/// Aux function: registers a new canvas for view, with the tiles
+static Canvas *AddCanvas (CURS_MOS *view, TileMap *tiles) {
+	Canvas *canvas = (Canvas *) malloc (sizeof (Canvas));
+	canvas->view = view;
+	canvas->tiles = tiles;
+	canvas->y = canvas->x = 0;
+	canvas->source = NULL;
+	canvas->decoded = NULL;
+	canvas->undecoded = 0;
+	canvas->corrupted = canvas->reported = 0;
+	canvas->origin_dev = 0;
+	canvas->origin_ino = 0;
+	canvas->whole = canvas->stowed = 0;
+	canvas->next = canvases;
+	canvases = canvas;
+
+	return canvas;
+}
+
+
+/// Aux function: lets go of the canvas' source, if there's one, unmapping
+/// it if no one else uses it
+static void DropSource (Canvas *canvas) {
+	if (canvas->source) {
+		if (--canvas->source->refs == 0) {
+			CloseBinary (&canvas->source->file);
+			free (canvas->source);
+		}
+		free (canvas->decoded);
+		canvas->source = NULL;
+		canvas->decoded = NULL;
+		canvas->undecoded = 0;
+	}
+}
+
+
+/**
+ * Aux function: reads row y from the source, blank if it's corrupted
+ *
+ * @return 1 if it's corrupted, 0 otherwise
+ */
+static int SourceRow (Canvas *canvas, int y, mos_char *chars, mos_attr *attrs) {
+	BinaryFile *file = &canvas->source->file;
+	if (ReadBinaryRow (file, y, chars, attrs)) {
+		memset (chars, ' ', file->width * sizeof (mos_char));
+		memset (attrs, 0, file->width * sizeof (mos_attr));
+		return 1;
+	}
+	return 0;
+}
+
+
+/// Aux function: decodes the bands with rows from y to y + height - 1 that
+/// are still only in the source into the tiles
+static void Reveal (Canvas *canvas, int y, int height) {
+	if (!canvas->source) {
+		return;
+	}
+
+	const int top = max (y, 0);
+	const int bottom = min (y + height, canvas->tiles->height);
+	if (bottom <= top) {
+		return;
+	}
+	const int first = top / TILE_SIZE, last = (bottom - 1) / TILE_SIZE;
+	MOSAIC *band = NULL;
+	int b, row;
+	for (b = first; b <= last; b++) {
+		if (canvas->decoded[b]) {
+			continue;
+		}
+		if (!band) {
+			band = NewMOSAIC (TILE_SIZE, canvas->tiles->width);
+		}
+		// the last band may be short: WriteTiles clips the rest
+		for (row = 0; row < TILE_SIZE && b * TILE_SIZE + row < canvas->tiles->height; row++) {
+			canvas->corrupted += SourceRow (canvas, b * TILE_SIZE + row,
+					band->mosaic + (size_t) row * band->width,
+					band->attr + (size_t) row * band->width);
+		}
+		WriteTiles (canvas->tiles, band, b * TILE_SIZE, 0);
+		canvas->decoded[b] = 1;
+		canvas->undecoded--;
+	}
+	if (band) {
+		FreeMOSAIC (band);
+	}
+
+	// everything is in the tiles: the file isn't needed anymore
+	if (canvas->undecoded == 0) {
+		DropSource (canvas);
+	}
+}
+
+
+/// Aux function: decodes whatever is still only in the source
+static void RevealAll (Canvas *canvas) {
+	Reveal (canvas, 0, canvas->tiles->height);
+}
+
+
+/// Aux function: is file_name the file the canvas' source came from?
+static int IsOrigin (Canvas *canvas, const char *file_name) {
+	struct stat info;
+	return stat (file_name, &info) == 0 && info.st_dev == canvas->origin_dev
+			&& info.st_ino == canvas->origin_ino;
+}
+
+
+/// Aux function: resizes the view for a canvas of height x width: to the
+/// whole image if it's whole and not too big, to the screen otherwise
+static void SizeView (Canvas *canvas, int height, int width) {
+	canvas->whole = canvas->whole && height <= MAX_DENSE_SIDE
+			&& width <= MAX_DENSE_SIDE;
+	if (canvas->whole) {
+		ResizeCURS_MOS (canvas->view, height, width);
+	}
+	else {
+		ResizeCURS_MOS (canvas->view, min (height, MOSAIC_PAD_HEIGHT),
+				min (width, MOSAIC_PAD_WIDTH));
+	}
+}
+
+
+/// Aux function: is the view the whole image (or stowed, being one)?
+static int Whole (Canvas *canvas) {
+	MOSAIC *view = canvas->view->img;
+	return canvas->stowed || (canvas->whole && canvas->y == 0
+			&& canvas->x == 0 && view->height == canvas->tiles->height
+			&& view->width == canvas->tiles->width);
+}
+
+
+/// Aux function: materializes the view again, and it's pad, if it's stowed
+static void Unstow (Canvas *canvas) {
+	if (!canvas->stowed) {
+		return;
+	}
+	canvas->stowed = 0;
+	RevealAll (canvas);
+	ResizeCURS_MOS (canvas->view, canvas->tiles->height, canvas->tiles->width);
+	ReadTiles (canvas->tiles, canvas->view->img, 0, 0);
+	RewriteCURS_MOS (canvas->view);
+}
+
+
+CURS_MOS *NewCanvas (int height, int width) {
+	CURS_MOS *view = NewCURS_MOS (min (height, MOSAIC_PAD_HEIGHT),
+			min (width, MOSAIC_PAD_WIDTH));
+	Canvas *canvas = AddCanvas (view, NewTileMap (height, width));
+	ReadTiles (canvas->tiles, view->img, 0, 0);
+
+	return view;
+}
+
+
+CURS_MOS *DuplicateCanvas (Canvas *canvas) {
+	Unstow (canvas);
+	// the copy has no source of it's own
+	RevealAll (canvas);
+	// what's in the view may not be in the tiles yet
+	WriteTiles (canvas->tiles, canvas->view->img, canvas->y, canvas->x);
+
+	CURS_MOS *view = NewCURS_MOS (canvas->view->img->height,
+			canvas->view->img->width);
+	Canvas *copy = AddCanvas (view, CopyTileMap (canvas->tiles));
+	copy->y = canvas->y;
+	copy->x = canvas->x;
+	// the blanks of corrupted rows came along
+	copy->corrupted = copy->reported = canvas->corrupted;
+	copy->origin_dev = canvas->origin_dev;
+	copy->origin_ino = canvas->origin_ino;
+	copy->whole = canvas->whole;
+	ReadTiles (copy->tiles, view->img, copy->y, copy->x);
+
+	return view;
+}
+
+
+Canvas *GetCanvas (CURS_MOS *img) {
+	Canvas *canvas;
+	for (canvas = canvases; canvas; canvas = canvas->next) {
+		if (canvas->view == img) {
+			return canvas;
+		}
+	}
+
+	return NULL;
+}
+
+
+void CanvasBounds (CURS_MOS *img, Rect *bounds) {
+	Canvas *canvas = GetCanvas (img);
+	if (canvas) {
+		bounds->ULy = -canvas->y;
+		bounds->ULx = -canvas->x;
+		bounds->BRy = canvas->tiles->height - 1 - canvas->y;
+		bounds->BRx = canvas->tiles->width - 1 - canvas->x;
+	}
+	else {
+		bounds->ULy = bounds->ULx = 0;
+		bounds->BRy = img->img->height - 1;
+		bounds->BRx = img->img->width - 1;
+	}
+}
+
+
+/**
+ * Aux function: the rows (or columns) of a view of size moving d that it
+ * doesn't share with where it goes: the ones leaving, in it's coordinates
+ * before moving, or the ones coming, after; from > to if there are none
+ */
+static void Edge (int d, int size, char leaving, int *from, int *to) {
+	if (d == 0) {
+		*from = 1;
+		*to = 0;
+	}
+	else if ((d > 0) == leaving) {
+		*from = 0;
+		*to = abs (d) - 1;
+	}
+	else {
+		*from = size - abs (d);
+		*to = size - 1;
+	}
+}
+
+
+/// Aux function: stores a rectangle of the view in the tiles, or reads it
+/// from them
+static void Transfer (Canvas *canvas, Rect r, char store) {
+	if (r.ULy > r.BRy || r.ULx > r.BRx) {
+		return;
+	}
+	MOSAIC *view = canvas->view->img;
+	MOSAIC *cells = NewMOSAIC (r.BRy - r.ULy + 1, r.BRx - r.ULx + 1);
+	const BlitKey opaque = {BLIT_OPAQUE, ' ', Normal};
+	if (store) {
+		BlitSource src = {view->mosaic + MOS_INDEX (view, r.ULy, r.ULx),
+				view->attr + MOS_INDEX (view, r.ULy, r.ULx),
+				cells->height, cells->width, view->width};
+		Blit (cells, 0, 0, src, opaque);
+		WriteTiles (canvas->tiles, cells, canvas->y + r.ULy, canvas->x + r.ULx);
+	}
+	else {
+		ReadTiles (canvas->tiles, cells, canvas->y + r.ULy, canvas->x + r.ULx);
+		BlitSource src = {cells->mosaic, cells->attr, cells->height,
+				cells->width, cells->width};
+		Blit (view, r.ULy, r.ULx, src, opaque);
+		MarkDirty (canvas->view, r.ULy, r.ULx, r.BRy, r.BRx);
+	}
+	FreeMOSAIC (cells);
+}
+
+
+/// Aux function: stores the edges of the view leaving it, or reads the
+/// ones coming, as it moves dy/dx
+static void TransferEdges (Canvas *canvas, int dy, int dx, char store) {
+	MOSAIC *view = canvas->view->img;
+	Rect rows = {0, 0, 0, view->width - 1};
+	Rect cols = {0, 0, view->height - 1, 0};
+	Edge (dy, view->height, store, &rows.ULy, &rows.BRy);
+	Edge (dx, view->width, store, &cols.ULx, &cols.BRx);
+	Transfer (canvas, rows, store);
+	Transfer (canvas, cols, store);
+}
+
+
+void ShowCanvasAt (Canvas *canvas, int y, int x) {
+	Unstow (canvas);
+	MOSAIC *view = canvas->view->img;
+	y = min (y, canvas->tiles->height - view->height);
+	x = min (x, canvas->tiles->width - view->width);
+	y = max (y, 0);
+	x = max (x, 0);
+	const int dy = y - canvas->y, dx = x - canvas->x;
+
+	// nothing in common: all of it goes, and comes
+	if (abs (dy) >= view->height || abs (dx) >= view->width) {
+		WriteTiles (canvas->tiles, view, canvas->y, canvas->x);
+		canvas->y = y;
+		canvas->x = x;
+		Reveal (canvas, y, view->height);
+		ReadTiles (canvas->tiles, view, y, x);
+		ENTER_(REDRAW);
+		return;
+	}
+
+	// the dirt and the selection box are in the old coordinates
+	FlushDirty ();
+	UnprintSelection (canvas->view);
+	// scrolled: only the edges leave the view or come to it, the rest
+	// just moves along, in the MOSAIC and in the pad
+	TransferEdges (canvas, dy, dx, 1);
+	ScrollCells (canvas->view, dy, dx);
+	canvas->y = y;
+	canvas->x = x;
+	Reveal (canvas, y, view->height);
+	TransferEdges (canvas, dy, dx, 0);
+}
+
+
+char FollowCanvas (CURS_MOS *img, int *y, int *x) {
+	Canvas *canvas = GetCanvas (img);
+	if (!canvas) {
+		return 0;
+	}
+
+	// where the cursor is in the canvas
+	const int canvas_y = canvas->y + *y;
+	const int canvas_x = canvas->x + *x;
+	const int new_y = FollowPosition (canvas->y, img->img->height,
+			canvas->tiles->height, canvas_y);
+	const int new_x = FollowPosition (canvas->x, img->img->width,
+			canvas->tiles->width, canvas_x);
+	if (new_y == canvas->y && new_x == canvas->x) {
+		return 0;
+	}
+	ShowCanvasAt (canvas, new_y, new_x);
+
+	*y = canvas_y - canvas->y;
+	*x = canvas_x - canvas->x;
+	return 1;
+}
+
+
+Canvas *MakeCanvas (CURS_MOS *img) {
+	Canvas *canvas = GetCanvas (img);
+	// not a canvas yet: the whole image goes to the tiles
+	if (!canvas) {
+		canvas = AddCanvas (img, NewTileMap (img->img->height, img->img->width));
+		WriteTiles (canvas->tiles, img->img, 0, 0);
+		canvas->whole = 1;
+	}
+
+	return canvas;
+}
+
+
+void ResizeCanvas (CURS_MOS *img, int height, int width) {
+	Canvas *canvas = MakeCanvas (img);
+	Unstow (canvas);
+	// the bands' rows would change
+	RevealAll (canvas);
+	// the old tiles stay shared with the record, until edited
+	RecordCanvas (img);
+	ResizeTileMap (canvas->tiles, height, width);
+
+	SizeView (canvas, height, width);
+	// the resized view holds nothing yet: read it before moving it inside
+	ReadTiles (canvas->tiles, img->img, canvas->y, canvas->x);
+	ShowCanvasAt (canvas, canvas->y, canvas->x);
+}
+
+
+void ReadCanvasCells (Canvas *canvas, MOSAIC *cells, int y, int x) {
+	WriteTiles (canvas->tiles, canvas->view->img, canvas->y, canvas->x);
+	Reveal (canvas, y, cells->height);
+	ReadTiles (canvas->tiles, cells, y, x);
+}
+
+
+void WriteCanvasCells (Canvas *canvas, MOSAIC *cells, int y, int x) {
+	MOSAIC *view = canvas->view->img;
+	WriteTiles (canvas->tiles, view, canvas->y, canvas->x);
+	// bands still in the source would overwrite the cells when decoded
+	Reveal (canvas, y, cells->height);
+	WriteTiles (canvas->tiles, cells, y, x);
+	if (y < canvas->y + view->height && canvas->y < y + cells->height
+			&& x < canvas->x + view->width && canvas->x < x + cells->width) {
+		ReadTiles (canvas->tiles, view, canvas->y, canvas->x);
+		// a stowed view has no pad to show
+		if (!canvas->stowed) {
+			ENTER_(REDRAW);
+		}
+	}
+}
+
+
+/// A band of TILE_SIZE rows, for writing canvases a row at a time
+typedef struct {
+	Canvas *canvas;	///< the canvas
+	MOSAIC *rows;	///< the band's cells
+} Band;
+
+
+/// Aux function: RowSource that reads the tiles a band at a time (rows
+/// come in order), or the source for bands still there
+static void BandRow (void *data, int y, mos_char *chars, mos_attr *attrs) {
+	Band *band = (Band *) data;
+	Canvas *canvas = band->canvas;
+	if (canvas->source && !canvas->decoded[y / TILE_SIZE]) {
+		SourceRow (canvas, y, chars, attrs);
+		return;
+	}
+
+	const int row = y % TILE_SIZE;
+	if (row == 0) {
+		ReadTiles (canvas->tiles, band->rows, y, 0);
+	}
+	memcpy (chars, band->rows->mosaic + (size_t) row * band->rows->width,
+			band->rows->width * sizeof (mos_char));
+	memcpy (attrs, band->rows->attr + (size_t) row * band->rows->width,
+			band->rows->width * sizeof (mos_attr));
+}
+
+
+int SaveCanvas (Canvas *canvas, const char *file_name, int *rows_done) {
+	// snapshots have no view, they're in the tiles already
+	if (canvas->view) {
+		WriteTiles (canvas->tiles, canvas->view->img, canvas->y, canvas->x);
+	}
+	const int height = canvas->tiles->height, width = canvas->tiles->width;
+	Band band = {canvas, NewMOSAIC (min (height, TILE_SIZE), width)};
+
+	// binary files are written a band at a time, never whole, and what's
+	// only in the source is copied from it without going to the tiles
+	if (BinaryName (file_name)) {
+		int ret = SaveBinaryRows (height, width, BandRow, &band, file_name,
+				rows_done);
+		FreeMOSAIC (band.rows);
+		return ret;
+	}
+
+	// the source's file would be truncated under the canvas
+	if (canvas->view && canvas->source && IsOrigin (canvas, file_name)) {
+		RevealAll (canvas);
+	}
+	MOSAIC *whole = NewMOSAIC (height, width);
+	int y;
+	for (y = 0; y < height; y++) {
+		BandRow (&band, y, whole->mosaic + (size_t) y * width,
+				whole->attr + (size_t) y * width);
+	}
+	FreeMOSAIC (band.rows);
+	int ret = SaveMOSAIC (whole, file_name);
+	FreeMOSAIC (whole);
+
+	return ret;
+}
+
+
+Canvas *SnapshotCanvas (Canvas *canvas, char reveal) {
+	if (reveal) {
+		RevealAll (canvas);
+	}
+	WriteTiles (canvas->tiles, canvas->view->img, canvas->y, canvas->x);
+
+	Canvas *snapshot = (Canvas *) malloc (sizeof (Canvas));
+	*snapshot = *canvas;
+	snapshot->view = NULL;
+	snapshot->next = NULL;
+	snapshot->tiles = CopyTileMap (canvas->tiles);
+	if (canvas->source) {
+		canvas->source->refs++;
+		const int bands = (canvas->tiles->height + TILE_SIZE - 1) / TILE_SIZE;
+		snapshot->decoded = (char *) malloc (bands + 1);
+		memcpy (snapshot->decoded, canvas->decoded, bands + 1);
+	}
+
+	return snapshot;
+}
+
+
+void FreeSnapshot (Canvas *snapshot) {
+	DropSource (snapshot);
+	FreeTileMap (snapshot->tiles);
+	free (snapshot);
+}
+
+
+void SwapSnapshot (Canvas *canvas, Canvas *snapshot, int height, int width) {
+	Unstow (canvas);
+	WriteTiles (canvas->tiles, canvas->view->img, canvas->y, canvas->x);
+	Canvas aux = *canvas;
+	canvas->tiles = snapshot->tiles;
+	canvas->y = snapshot->y;
+	canvas->x = snapshot->x;
+	canvas->source = snapshot->source;
+	canvas->decoded = snapshot->decoded;
+	canvas->undecoded = snapshot->undecoded;
+	canvas->corrupted = canvas->reported = snapshot->corrupted;
+	canvas->origin_dev = snapshot->origin_dev;
+	canvas->origin_ino = snapshot->origin_ino;
+	snapshot->tiles = aux.tiles;
+	snapshot->y = aux.y;
+	snapshot->x = aux.x;
+	snapshot->source = aux.source;
+	snapshot->decoded = aux.decoded;
+	snapshot->undecoded = aux.undecoded;
+	snapshot->corrupted = aux.corrupted;
+	snapshot->origin_dev = aux.origin_dev;
+	snapshot->origin_ino = aux.origin_ino;
+
+	ResizeCURS_MOS (canvas->view, height, width);
+	Reveal (canvas, canvas->y, height);
+	ReadTiles (canvas->tiles, canvas->view->img, canvas->y, canvas->x);
+	ENTER_(REDRAW);
+}
+
+
+/// Aux function: makes the tiles the canvas', showing them from the start
+static void TakeTiles (Canvas *canvas, TileMap *tiles) {
+	FreeTileMap (canvas->tiles);
+	canvas->tiles = tiles;
+	canvas->y = canvas->x = 0;
+
+	SizeView (canvas, tiles->height, tiles->width);
+	Reveal (canvas, 0, canvas->view->img->height);
+	ReadTiles (canvas->tiles, canvas->view->img, 0, 0);
+	ENTER_(REDRAW);
+}
+
+
+/// Aux function: maps a binary file as the canvas' source, with no band
+/// decoded yet
+static int MapBinary (Canvas *canvas, const char *file_name) {
+	CanvasSource *source = (CanvasSource *) malloc (sizeof (CanvasSource));
+	int ret = OpenBinary (&source->file, file_name);
+	if (ret) {
+		free (source);
+		return ret;
+	}
+	source->refs = 1;
+
+	Unstow (canvas);
+	BeginEdit (canvas->view, 0);
+	RecordCanvas (canvas->view);
+	DropSource (canvas);
+	struct stat info;
+	stat (file_name, &info);
+	canvas->origin_dev = info.st_dev;
+	canvas->origin_ino = info.st_ino;
+	canvas->source = source;
+	canvas->undecoded = (source->file.height + TILE_SIZE - 1) / TILE_SIZE;
+	canvas->decoded = (char *) calloc (canvas->undecoded + 1, sizeof (char));
+	TakeTiles (canvas, NewTileMap (source->file.height, source->file.width));
+
+	return 0;
+}
+
+
+void SetCanvasMOSAIC (Canvas *canvas, MOSAIC *img) {
+	Unstow (canvas);
+	BeginEdit (canvas->view, 0);
+	RecordCanvas (canvas->view);
+	TileMap *tiles = NewTileMap (img->height, img->width);
+	WriteTiles (tiles, img, 0, 0);
+	DropSource (canvas);
+	canvas->corrupted = canvas->reported = 0;
+	canvas->origin_dev = 0;
+	canvas->origin_ino = 0;
+	TakeTiles (canvas, tiles);
+}
+
+
+int LoadCanvas (Canvas *canvas, const char *file_name) {
+	if (IsBinary (file_name)) {
+		const int ret = MapBinary (canvas, file_name);
+		if (ret == 0) {
+			ReplayJournalCanvas (file_name, canvas);
+		}
+		return ret;
+	}
+
+	MOSAIC *whole = NewMOSAIC (0, 0);
+	int ret = LoadAnyMOSAIC (whole, file_name);
+	if (LoadedChars (ret)) {
+		SetCanvasMOSAIC (canvas, whole);
+	}
+	FreeMOSAIC (whole);
+
+	return ret;
+}
+
+
+int NewCorruptedRows (CURS_MOS *img) {
+	Canvas *canvas = GetCanvas (img);
+	if (!canvas) {
+		return 0;
+	}
+	const int rows = canvas->corrupted - canvas->reported;
+	canvas->reported = canvas->corrupted;
+	return rows;
+}
+
+
+int OverwritesCorrupted (CURS_MOS *img, const char *file_name) {
+	Canvas *canvas = GetCanvas (img);
+	return canvas && canvas->corrupted && IsOrigin (canvas, file_name);
+}
+
+
+int OverwritesSource (CURS_MOS *img, const char *file_name) {
+	Canvas *canvas = GetCanvas (img);
+	return canvas && canvas->source && IsOrigin (canvas, file_name);
+}
+
+
+int WholeCanvas (CURS_MOS *img) {
+	Canvas *canvas = GetCanvas (img);
+	return canvas && Whole (canvas);
+}
+
+
+void FitCanvas (CURS_MOS *img) {
+	Canvas *canvas = GetCanvas (img);
+	if (!canvas) {
+		return;
+	}
+	RevealAll (canvas);
+	canvas->y = canvas->x = 0;
+	canvas->whole = 1;
+	ResizeTileMap (canvas->tiles, img->img->height, img->img->width);
+	WriteTiles (canvas->tiles, img->img, 0, 0);
+}
+
+
+void StowCanvases (CURS_MOS *current) {
+	Canvas *canvas;
+	for (canvas = canvases; canvas; canvas = canvas->next) {
+		if (canvas->view == current || canvas->stowed || !Whole (canvas)) {
+			continue;
+		}
+		// it's dirt would be written in a pad that's gone
+		FlushDirty ();
+		WriteTiles (canvas->tiles, canvas->view->img, 0, 0);
+		ResizeCURS_MOS (canvas->view, 1, 1);
+		// what reads the tiles writes the view in them first
+		ReadTiles (canvas->tiles, canvas->view->img, 0, 0);
+		canvas->stowed = 1;
+	}
+}
+
+
+MOSAIC *WholeMOSAIC (CURS_MOS *img, char *copy) {
+	Canvas *canvas = GetCanvas (img);
+	*copy = canvas != NULL;
+	if (!canvas) {
+		return img->img;
+	}
+	MOSAIC *whole = NewMOSAIC (canvas->tiles->height, canvas->tiles->width);
+	if (whole) {
+		ReadCanvasCells (canvas, whole, 0, 0);
+	}
+	return whole;
+}
+
+
+int StowedCanvas (CURS_MOS *img) {
+	Canvas *canvas = GetCanvas (img);
+	return canvas && canvas->stowed;
+}
+
+
+void UnstowCanvas (CURS_MOS *img) {
+	Canvas *canvas = GetCanvas (img);
+	if (canvas) {
+		Unstow (canvas);
+	}
+}
+
+
+void DestroyCanvases () {
+	Canvas *aux;
+	while (canvases) {
+		aux = canvases->next;
+		DropSource (canvases);
+		FreeTileMap (canvases->tiles);
+		free (canvases);
+		canvases = aux;
+	}
+}
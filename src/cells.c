@@ -0,0 +1,197 @@
+#include "cells.h"
+#include "onion.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+chtype CursesAttr (mos_attr attr) {
+	// take the flags off, so only the color pair is left in attr
+	mos_attr bold = extractBold (&attr);
+	mos_attr underline = extractUnderline (&attr);
+
+	return COLOR_PAIR (attr) | (bold ? A_BOLD : 0)
+			| (underline ? A_UNDERLINE : 0);
+}
+
+
+void RewriteSpan (CURS_MOS *current, int y, int from, int to) {
+	MOSAIC *img = current->img;
+
+	// clip it, so we never read outside the MOSAIC
+	if (y < 0 || y >= img->height) {
+		return;
+	}
+	from = max (from, 0);
+	to = min (to, img->width - 1);
+	if (from > to) {
+		return;
+	}
+
+	// build the whole span first, so curses gets it in one call
+	chtype span[to - from + 1];
+	const chtype *under = OnionRow (current, y);
+	int x;
+	for (x = from; x <= to; x++) {
+		const mos_char ch = _mosGetCh (img, y, x);
+		const mos_attr attr = _mosGetAttr (img, y, x);
+		// blank: the onion skin shows through, if there's something there
+		if (under && under[x] && ch == ' ' && attr == Normal) {
+			span[x - from] = under[x];
+		}
+		else {
+			span[x - from] = (unsigned char) ch | CursesAttr (attr);
+		}
+	}
+	mvwaddchnstr (current->win, y, from, span, to - from + 1);
+}
+
+
+void RewriteRect (CURS_MOS *current, int ULy, int ULx, int BRy, int BRx) {
+	int y;
+	BRy = min (BRy, current->img->height - 1);
+	for (y = max (ULy, 0); y <= BRy; y++) {
+		RewriteSpan (current, y, ULx, BRx);
+	}
+}
+
+
+void ScrollCells (CURS_MOS *current, int dy, int dx) {
+	MOSAIC *img = current->img;
+	const int height = img->height - abs (dy), width = img->width - abs (dx);
+	if (height <= 0 || width <= 0) {
+		return;
+	}
+
+	// rows are taken in the order that doesn't overwrite the ones to come
+	const int first = dy > 0 ? 0 : img->height - 1, step = dy > 0 ? 1 : -1;
+	const int from = max (dx, 0), to = max (-dx, 0);
+	chtype row[width + 1];
+	int i, y;
+	for (i = 0, y = first; i < height; i++, y += step) {
+		memmove (img->mosaic + MOS_INDEX (img, y, to),
+				img->mosaic + MOS_INDEX (img, y + dy, from),
+				width * sizeof (mos_char));
+		memmove (img->attr + MOS_INDEX (img, y, to),
+				img->attr + MOS_INDEX (img, y + dy, from),
+				width * sizeof (mos_attr));
+		if (dx) {
+			mvwinchnstr (current->win, y + dy, from, row, width);
+			mvwaddchnstr (current->win, y, to, row, width);
+		}
+	}
+
+	// whole rows: curses just moves them
+	if (!dx && dy) {
+		scrollok (current->win, TRUE);
+		wscrl (current->win, dy);
+		scrollok (current->win, FALSE);
+	}
+}
+
+
+void ShiftLine (MOSAIC *img, int y, int x, Direction dir) {
+	mos_char *chars = img->mosaic;
+	mos_attr *attrs = img->attr;
+	const int here = MOS_INDEX (img, y, x);
+	int i, n;
+
+	switch (dir) {
+		// rows are contiguous: a memmove does it
+		case RIGHT:
+			n = img->width - 1 - x;
+			if (n > 0) {
+				memmove (chars + here + 1, chars + here, n * sizeof (mos_char));
+				memmove (attrs + here + 1, attrs + here, n * sizeof (mos_attr));
+			}
+			break;
+
+		case LEFT:
+			n = x;
+			if (n > 0) {
+				i = MOS_INDEX (img, y, 0);
+				memmove (chars + i, chars + i + 1, n * sizeof (mos_char));
+				memmove (attrs + i, attrs + i + 1, n * sizeof (mos_attr));
+			}
+			break;
+
+		// columns are strided, one row apart
+		case DOWN:
+			for (i = MOS_INDEX (img, img->height - 1, x); i > here;
+					i -= img->width) {
+				chars[i] = chars[i - img->width];
+				attrs[i] = attrs[i - img->width];
+			}
+			break;
+
+		case UP:
+			for (i = x; i < here; i += img->width) {
+				chars[i] = chars[i + img->width];
+				attrs[i] = attrs[i + img->width];
+			}
+			break;
+	}
+}
+
+
+/**
+ * Aux function: fill n elements of a given size with value
+ *
+ * Bytes are just memset; wider types get the first element copied,
+ * then the filled part is doubled with memcpy until it's all done
+ */
+static void FillSpan (void *dst, const void *value, size_t size, size_t n) {
+	if (size == 1) {
+		memset (dst, *(const unsigned char *) value, n);
+		return;
+	}
+
+	char *out = (char *) dst;
+	const size_t total = n * size;
+	size_t filled = size;
+	memcpy (out, value, size);
+	while (filled < total) {
+		size_t chunk = filled < total - filled ? filled : total - filled;
+		memcpy (out + filled, out, chunk);
+		filled += chunk;
+	}
+}
+
+
+void FillRect (MOSAIC *img, int ULy, int ULx, int BRy, int BRx,
+		mos_char c, mos_attr attr, int what) {
+	// clip it once, so no cell needs checking
+	ULy = max (ULy, 0);
+	ULx = max (ULx, 0);
+	BRy = min (BRy, img->height - 1);
+	BRx = min (BRx, img->width - 1);
+	if (ULy > BRy || ULx > BRx) {
+		return;
+	}
+
+	int n = BRx - ULx + 1;
+	// full rows are contiguous: fill them as one big span
+	if (n == img->width) {
+		n *= BRy - ULy + 1;
+		BRy = ULy;
+	}
+
+	mos_char *chars = img->mosaic + MOS_INDEX (img, ULy, ULx);
+	mos_attr *attrs = img->attr + MOS_INDEX (img, ULy, ULx);
+	// first row span...
+	if (what & FILL_CH) {
+		FillSpan (chars, &c, sizeof (mos_char), n);
+	}
+	if (what & FILL_ATTR) {
+		FillSpan (attrs, &attr, sizeof (mos_attr), n);
+	}
+	// ...and the others are copies of it
+	int i;
+	for (i = img->width; ULy < BRy; ULy++, i += img->width) {
+		if (what & FILL_CH) {
+			memcpy (chars + i, chars, n * sizeof (mos_char));
+		}
+		if (what & FILL_ATTR) {
+			memcpy (attrs + i, attrs, n * sizeof (mos_attr));
+		}
+	}
+}
@@ -0,0 +1,98 @@
+#include "dirty.h"
+#include "cells.h"
+#include "positioning.h"
+#include "onion.h"
+
+/// The dirty rectangles, all from the same CURS_MOS
+static struct {
+	CURS_MOS *owner;	///< whose pad is outdated; NULL if nobody's
+	Rect rects[DIRTY_RECTS];	///< the outdated rectangles
+	int size;	///< how many rects are there
+} dirty;
+
+
+/// Aux function: do a and b overlap or touch each other?
+static int Touching (Rect a, Rect b) {
+	return a.ULy <= b.BRy + 1 && b.ULy <= a.BRy + 1
+			&& a.ULx <= b.BRx + 1 && b.ULx <= a.BRx + 1;
+}
+
+
+/// Aux function: grow a, so that it contains b too
+static void Merge (Rect *a, Rect b) {
+	a->ULy = min (a->ULy, b.ULy);
+	a->ULx = min (a->ULx, b.ULx);
+	a->BRy = max (a->BRy, b.BRy);
+	a->BRx = max (a->BRx, b.BRx);
+}
+
+
+void MarkDirty (CURS_MOS *img, int ULy, int ULx, int BRy, int BRx) {
+	Rect new_rect;
+	new_rect.ULy = max (ULy, 0);
+	new_rect.ULx = max (ULx, 0);
+	new_rect.BRy = min (BRy, img->img->height - 1);
+	new_rect.BRx = min (BRx, img->img->width - 1);
+	if (new_rect.ULy > new_rect.BRy || new_rect.ULx > new_rect.BRx) {
+		return;
+	}
+	// what shows through the current image may have changed too
+	OnionDirty (img, new_rect.ULy, new_rect.ULx, new_rect.BRy, new_rect.BRx);
+
+	// we track only one CURS_MOS, so the old one's pad is written now
+	if (dirty.owner != img) {
+		FlushDirty ();
+		dirty.owner = img;
+	}
+
+	// merge everyone that touches the new rect, as merging may
+	// make it touch some other one, that's then merged too
+	int i = 0;
+	while (i < dirty.size) {
+		if (Touching (dirty.rects[i], new_rect)) {
+			Merge (&new_rect, dirty.rects[i]);
+			dirty.rects[i] = dirty.rects[--dirty.size];
+			i = 0;
+		}
+		else {
+			i++;
+		}
+	}
+
+	// too many of them: collapse it all in one big rect
+	if (dirty.size == DIRTY_RECTS) {
+		for (i = 0; i < dirty.size; i++) {
+			Merge (&new_rect, dirty.rects[i]);
+		}
+		dirty.size = 0;
+	}
+	dirty.rects[dirty.size++] = new_rect;
+}
+
+
+void MarkAllDirty (CURS_MOS *img) {
+	MarkDirty (img, 0, 0, img->img->height - 1, img->img->width - 1);
+}
+
+
+int FlushDirty () {
+	int i, flushed = dirty.size;
+	for (i = 0; i < dirty.size; i++) {
+		// clip again, as the image may have shrunk since it was marked
+		RewriteRect (dirty.owner, dirty.rects[i].ULy, dirty.rects[i].ULx,
+				dirty.rects[i].BRy, dirty.rects[i].BRx);
+	}
+
+	dirty.size = 0;
+	dirty.owner = NULL;
+
+	return flushed;
+}
+
+
+void DiscardDirty (CURS_MOS *img) {
+	if (dirty.owner == img) {
+		dirty.size = 0;
+		dirty.owner = NULL;
+	}
+}
@@ -0,0 +1,228 @@
+#include "export.h"
+#include "cells.h"
+#include "binary.h"
+
+#include <mosaic/color.h>
+#include <mosaic/stream_io.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// SGR codes for the colors, in the order libmosaic numbers them (after Normal)
+#define SGR_FORE 30
+#define SGR_BACK 40
+/// SGR codes for the terminal's default colors
+#define SGR_DEFAULT_FORE 39
+#define SGR_DEFAULT_BACK 49
+
+/// The writer's buffer size: output goes out in chunks this big
+#define WRITER_SIZE (1 << 20)
+
+/// A buffered writer, so we don't pay stdio's locking per char
+typedef struct {
+	FILE *out;	///< where it all goes
+	char *buf;	///< the buffer
+	size_t used;	///< how much of buf is used
+	int err;	///< the first write error; 0 if none
+} Writer;
+
+
+/// Aux function: sends what's in the buffer
+static void Flush (Writer *w) {
+	if (w->used && fwrite (w->buf, 1, w->used, w->out) != w->used && !w->err) {
+		w->err = errno;
+	}
+	w->used = 0;
+}
+
+
+/// Aux function: buffers n bytes
+static void Put (Writer *w, const char *data, size_t n) {
+	while (n > 0) {
+		if (w->used == WRITER_SIZE) {
+			Flush (w);
+		}
+		size_t chunk = WRITER_SIZE - w->used;
+		chunk = chunk < n ? chunk : n;
+		memcpy (w->buf + w->used, data, chunk);
+		w->used += chunk;
+		data += chunk;
+		n -= chunk;
+	}
+}
+
+
+/// Aux function: buffers a single char
+static void PutChar (Writer *w, char c) {
+	if (w->used == WRITER_SIZE) {
+		Flush (w);
+	}
+	w->buf[w->used++] = c;
+}
+
+
+/// Aux function: opens a writer to out
+static int OpenWriter (Writer *w, FILE *out) {
+	w->out = out;
+	w->used = 0;
+	w->err = 0;
+	w->buf = (char *) malloc (WRITER_SIZE);
+
+	return w->buf ? 0 : ENOMEM;
+}
+
+
+/// Aux function: flushes and closes the writer
+static int CloseWriter (Writer *w) {
+	Flush (w);
+	free (w->buf);
+	if (fflush (w->out) && !w->err) {
+		w->err = errno;
+	}
+
+	return w->err;
+}
+
+
+/// Aux function: writes the SGR sequence that goes from attr from to to
+static void WriteSGR (Writer *w, mos_attr from, mos_attr to) {
+	mos_attr from_bold = extractBold (&from);
+	mos_attr from_underline = extractUnderline (&from);
+	mos_attr to_bold = extractBold (&to);
+	mos_attr to_underline = extractUnderline (&to);
+
+	// only what changed; at most 4 codes
+	int codes[4], n = 0;
+	if (!from_bold != !to_bold) {
+		codes[n++] = to_bold ? 1 : 22;
+	}
+	if (!from_underline != !to_underline) {
+		codes[n++] = to_underline ? 4 : 24;
+	}
+	// color 0 is Normal: the terminal's default
+	const int fore = GetFore (to), back = GetBack (to);
+	if (GetFore (from) != fore) {
+		codes[n++] = fore ? SGR_FORE + fore - 1 : SGR_DEFAULT_FORE;
+	}
+	if (GetBack (from) != back) {
+		codes[n++] = back ? SGR_BACK + back - 1 : SGR_DEFAULT_BACK;
+	}
+
+	char sgr[32];
+	int i, len = sprintf (sgr, "\033[");
+	for (i = 0; i < n; i++) {
+		len += sprintf (sgr + len, i ? ";%d" : "%d", codes[i]);
+	}
+	sgr[len++] = 'm';
+	Put (w, sgr, len);
+}
+
+
+/// Aux function: is the cell invisible when it's the last in a line?
+static int Invisible (mos_char ch, mos_attr attr) {
+	// a blank shows only it's background and underline
+	return ch == ' ' && !GetBack (attr & ~(BOLD | UNDERLINE))
+			&& !extractUnderline (&attr);
+}
+
+
+int ExportANSI (MOSAIC *img, FILE *out) {
+	Writer w;
+	if (OpenWriter (&w, out)) {
+		return ENOMEM;
+	}
+
+	int y, x, end;
+	for (y = 0; y < img->height; y++) {
+		const mos_char *chars = img->mosaic + MOS_INDEX (img, y, 0);
+		const mos_attr *attrs = img->attr + MOS_INDEX (img, y, 0);
+		// blanks that wouldn't show at the end of the line are left out
+		end = img->width;
+		while (end > 0 && Invisible (chars[end - 1], attrs[end - 1])) {
+			end--;
+		}
+
+		// every line starts with the terminal's defaults; then, a run of
+		// cells at a time, with the same attribute
+		mos_attr current = Normal;
+		for (x = 0; x < end; ) {
+			const int run = x;
+			if (attrs[x] != current) {
+				WriteSGR (&w, current, attrs[x]);
+				current = attrs[x];
+			}
+			do {
+				x++;
+			} while (x < end && attrs[x] == current);
+			Put (&w, (const char *) chars + run, x - run);
+		}
+		if (current != Normal) {
+			Put (&w, "\033[0m", 4);
+		}
+		PutChar (&w, '\n');
+	}
+
+	return CloseWriter (&w);
+}
+
+
+int ExportText (MOSAIC *img, FILE *out) {
+	Writer w;
+	if (OpenWriter (&w, out)) {
+		return ENOMEM;
+	}
+
+	int y;
+	for (y = 0; y < img->height; y++) {
+		Put (&w, (const char *) img->mosaic + MOS_INDEX (img, y, 0),
+				img->width * sizeof (mos_char));
+		PutChar (&w, '\n');
+	}
+
+	return CloseWriter (&w);
+}
+
+
+const char *LoadError (int err) {
+	switch (err) {
+		case ENODIMENSIONS:
+			return "no dimensions in the file";
+
+		case EUNKNSTRGFMT:
+			return "couldn't load the attributes";
+
+		default:
+			return strerror (err);
+	}
+}
+
+
+int Headless (const char *file_name, char dimensions, char color) {
+	if (!file_name) {
+		fputs ("maae: no input file\n", stderr);
+		return 1;
+	}
+
+	MOSAIC *img = NewMOSAIC (0, 0);
+	int ret = LoadAnyMOSAIC (img, file_name);
+	if (!LoadedChars (ret)) {
+		fprintf (stderr, "maae: %s: %s\n", file_name, LoadError (ret));
+		FreeMOSAIC (img);
+		return 1;
+	}
+	else if (ret) {
+		fprintf (stderr, "maae: %s: %s\n", file_name, LoadError (ret));
+	}
+
+	if (dimensions) {
+		printf ("%dx%d\n", img->height, img->width);
+	}
+	ret = color ? ExportANSI (img, stdout) : 0;
+	FreeMOSAIC (img);
+
+	if (ret || fflush (stdout)) {
+		fprintf (stderr, "maae: %s\n", strerror (ret ? ret : errno));
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,43 @@
+#include "frame.h"
+
+#include <curses.h>
+#include <time.h>
+
+/// Minimum time between frames, in milliseconds
+static long frame_interval = 1000 / DEFAULT_MAX_FPS;
+/// When the last frame was drawn
+static struct timespec last_frame;
+
+
+/// Aux function: milliseconds since the last frame
+static long SinceLastFrame () {
+	struct timespec now;
+	clock_gettime (CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - last_frame.tv_sec) * 1000
+			+ (now.tv_nsec - last_frame.tv_nsec) / 1000000;
+}
+
+
+void SetMaxFrameRate (int fps) {
+	frame_interval = fps > 0 ? 1000 / fps : 0;
+}
+
+
+int NextFrameKey () {
+	// wait just until the frame is due; 0 is only what's queued
+	long wait = frame_interval - SinceLastFrame ();
+	timeout (wait > 0 ? wait : 0);
+	int c = getch ();
+	// and back to blocking, as everyone else expects
+	timeout (-1);
+
+	return c;
+}
+
+
+void EndFrame () {
+	// cursor goes where stdscr's is (UpdateHud puts it there)
+	wnoutrefresh (stdscr);
+	doupdate ();
+	clock_gettime (CLOCK_MONOTONIC, &last_frame);
+}
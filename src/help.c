@@ -23,18 +23,18 @@ void InitHelp () {
 	// the hotkeys
 	const char *hotkeys[] = {
 		"F1", "F10/Mouse Right Button", "^Q",
-		"Arrow Keys", "^D", "^A", "Page Up/Page Down", "^G", "Home/End", "Mouse Left Button", "Mouse Left Button double click",
-		"^B", "^T", "^P", "Insert", "^N",
-		"F2", "^S", "^O", "^R", "^K", "^C/^X", "^V", "Tab", "^U", "^W"
+		"Arrow Keys", "^D", "^A", "Page Up/Page Down", "^G", "F5", "Home/End", "Mouse Left Button", "Mouse Left Button double click",
+		"^B", "^T", "^P", "Insert", "F6", "^N",
+		"F2", "^S", "^O", "^R", "^K", "^C/^X", "^V", "F7", "Tab", "^U", "^W", "^Z/^Y"
 	};
 	// and how many are there for each subtitle
-	int n_hotkeys[] = {3, 8, 5, 10};
+	int n_hotkeys[] = {3, 9, 6, 12};
 	// what the hotkeys do
 	const char *explanations[] = {
 		"show this help", "show the menu", "quit Maae",
-		"move through the mosaic", "change the moving direction after input (default direction)", "select all", "previous/next mosaic", "go to mosaic by index", "move to first/last character (in the default direction)", "move to", "select until",
-		"toggle box selection mode", "toggle transparent pasting mode", "toggle paint mode", "toggle insert mode", "enter move selection mode",
-		"new mosaic", "save mosaic", "load mosaic", "resize mosaic", "trim mosaic", "copy/cut selection", "paste selection", "show the attribute table", "erase line", "erase word"
+		"move through the mosaic", "change the moving direction after input (default direction)", "select all", "previous/next mosaic", "go to mosaic by index", "play the mosaics as an animation (any key stops)", "move to first/last character (in the default direction)", "move to", "select until",
+		"toggle box selection mode", "toggle transparent pasting mode", "toggle paint mode", "toggle insert mode", "toggle onion skin (previous/next mosaics dimmed under this one)", "enter move selection mode",
+		"new mosaic", "save mosaic", "load mosaic", "resize mosaic", "trim mosaic", "copy/cut selection", "paste selection", "paste, fill, recolor or erase in a range of mosaics", "show the attribute table", "erase line", "erase word", "undo/redo"
 	};
 	
 	// aux counters; only 'i' gets reseted at 0, as it counts until n_hotkeys ends
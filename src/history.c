@@ -0,0 +1,541 @@
+#include "history.h"
+#include "journal.h"
+#include "maae.h"
+
+/// A record: some cells, as they were before (or after) a change
+typedef struct record {
+	Rect rect;	///< the recorded cells; for whole images, their dimensions
+	char whole;	///< is it the whole image (rect.BRy + 1 by rect.BRx + 1)?
+	Canvas *canvas;	///< for whole canvases, the snapshot; rect is the view
+	mos_char *chars;	///< the cells' chars, row-major
+	mos_attr *attrs;	///< the cells' attributes, row-major
+	size_t bytes;	///< memory used by the record, when last counted
+	struct record *prev, *next;
+} Record;
+
+/// An undo step: the records of one user action, in one image
+typedef struct step {
+	CURS_MOS *img;	///< the edited image
+	int y, x;	///< where img's view was, if it's a canvas
+	char coalescing;	///< may the next edit be merged in this step?
+	char joined;	///< is it undone and redone along with the step before?
+	size_t bytes;	///< memory used by the step
+	Record *first, *last;	///< the records, in the order they were made
+	struct step *prev, *next;
+} Step;
+
+/// The journal: oldest steps first; the ones after top were undone
+static struct {
+	Step *first;	///< oldest step
+	Step *top;	///< last step applied; NULL if everything was undone
+	Step *open;	///< step being recorded, if any
+	char coalesce;	///< if a new step is opened, may it coalesce?
+	char join;	///< joining new steps? 1 until the first is opened, then 2
+	Step *group;	///< first step of the joined ones being recorded, if any
+	size_t bytes;	///< memory used by all the steps
+	int snapshots;	///< canvas snapshots among the records
+	size_t limit;	///< the memory cap
+	unsigned long edits;	///< changes recorded, undone or redone so far
+} history = {NULL, NULL, NULL, 0, 0, NULL, 0, 0, DEFAULT_HISTORY_KB * 1024, 0};
+
+
+/// Aux function: the cells in a record
+static int Cells (Rect r) {
+	return (r.BRy - r.ULy + 1) * (r.BRx - r.ULx + 1);
+}
+
+
+/// Aux function: free a step and it's records
+static void FreeStep (Step *step) {
+	Record *rec, *aux;
+	for (rec = step->first; rec; rec = aux) {
+		aux = rec->next;
+		if (rec->canvas) {
+			FreeSnapshot (rec->canvas);
+			history.snapshots--;
+		}
+		free (rec->chars);
+		free (rec->attrs);
+		free (rec);
+	}
+	history.bytes -= step->bytes;
+	free (step);
+}
+
+
+/// Aux function: free every step from step on
+static void FreeSteps (Step *step) {
+	Step *aux;
+	for ( ; step; step = aux) {
+		aux = step->next;
+		FreeStep (step);
+	}
+}
+
+
+/// Aux function: memory used by a record
+static size_t RecordBytes (Record *rec) {
+	if (rec->canvas) {
+		return sizeof (Record) + sizeof (Canvas) + TileMapBytes (rec->canvas->tiles);
+	}
+	return sizeof (Record)
+			+ Cells (rec->rect) * (sizeof (mos_char) + sizeof (mos_attr));
+}
+
+
+/// Aux function: counts rec's memory again, updating step's and the total
+static void Recount (Step *step, Record *rec) {
+	const size_t bytes = RecordBytes (rec);
+	step->bytes += bytes - rec->bytes;
+	history.bytes += bytes - rec->bytes;
+	rec->bytes = bytes;
+}
+
+
+/// Aux function: counts the snapshots again, as a shared tile is only part
+/// of their memory until the canvas writes over it (and copies it)
+static void RecountSnapshots () {
+	Step *step;
+	Record *rec;
+	for (step = history.first; step; step = step->next) {
+		for (rec = step->first; rec; rec = rec->next) {
+			if (rec->canvas) {
+				Recount (step, rec);
+			}
+		}
+	}
+}
+
+
+/// Aux function: evict oldest steps until we're under the cap (and the
+/// ones joined to an evicted one, as they can't be undone without it)
+static void Evict () {
+	if (history.snapshots) {
+		RecountSnapshots ();
+	}
+	while (history.first && history.first != history.open
+			&& history.first != history.group
+			&& (history.bytes > history.limit || history.first->joined)) {
+		Step *oldest = history.first;
+		history.first = oldest->next;
+		if (history.first) {
+			history.first->prev = NULL;
+		}
+		if (history.top == oldest) {
+			history.top = NULL;
+		}
+		FreeStep (oldest);
+	}
+}
+
+
+/// Aux function: opens a new step in img, after top, forgetting redos
+static Step *OpenStep (CURS_MOS *img) {
+	// another user action: the last joined steps may be evicted now
+	if (!history.join) {
+		history.group = NULL;
+	}
+	// the undone steps can't be redone anymore
+	if (history.top) {
+		FreeSteps (history.top->next);
+		history.top->next = NULL;
+	}
+	else {
+		FreeSteps (history.first);
+		history.first = NULL;
+	}
+
+	Step *step = (Step *) calloc (1, sizeof (Step));
+	step->img = img;
+	Canvas *canvas = GetCanvas (img);
+	if (canvas) {
+		step->y = canvas->y;
+		step->x = canvas->x;
+	}
+	step->coalescing = history.coalesce;
+	step->joined = history.join == 2;
+	if (history.join == 1) {
+		history.join = 2;
+		history.group = step;
+	}
+	step->bytes = sizeof (Step);
+	history.bytes += step->bytes;
+
+	step->prev = history.top;
+	if (history.top) {
+		history.top->next = step;
+	}
+	else {
+		history.first = step;
+	}
+	history.top = history.open = step;
+
+	return step;
+}
+
+
+/// Aux function: has step's canvas view moved since it was recorded?
+static int Moved (Step *step) {
+	Canvas *canvas = GetCanvas (step->img);
+	return canvas && (canvas->y != step->y || canvas->x != step->x);
+}
+
+
+/// Aux function: moves step's canvas view back to where it was recorded
+static void ShowStep (Step *step) {
+	if (Moved (step)) {
+		ShowCanvasAt (GetCanvas (step->img), step->y, step->x);
+	}
+}
+
+
+/// Aux function: appends a record to the open step, and counts it's memory
+static void AddRecord (Step *step, Record *rec) {
+	rec->prev = step->last;
+	rec->next = NULL;
+	if (step->last) {
+		step->last->next = rec;
+	}
+	else {
+		step->first = rec;
+	}
+	step->last = rec;
+
+	rec->bytes = RecordBytes (rec);
+	step->bytes += rec->bytes;
+	history.bytes += rec->bytes;
+	if (rec->canvas) {
+		history.snapshots++;
+	}
+	Evict ();
+}
+
+
+void SetHistoryLimit (int kb) {
+	history.limit = (size_t) kb * 1024;
+	Evict ();
+}
+
+
+void JoinEdits (char join) {
+	history.join = join ? 1 : 0;
+	history.open = NULL;
+}
+
+
+void BeginEdit (CURS_MOS *img, char coalesce) {
+	// keep going in the open step only if both sides agree
+	if (!(coalesce && history.open && history.open->coalescing
+				&& history.open->img == img)) {
+		history.open = NULL;
+	}
+	history.coalesce = coalesce;
+}
+
+
+/// Aux function: copies the cells in rect from img (or to, if backwards);
+/// a stowed canvas' are in the tiles, so it stays stowed
+static void CopyCells (CURS_MOS *img, Rect r, mos_char *chars, mos_attr *attrs,
+		char backwards) {
+	const int width = r.BRx - r.ULx + 1;
+	if (StowedCanvas (img)) {
+		MOSAIC *cells = NewMOSAIC (r.BRy - r.ULy + 1, width);
+		if (backwards) {
+			memcpy (cells->mosaic, chars, Cells (r) * sizeof (mos_char));
+			memcpy (cells->attr, attrs, Cells (r) * sizeof (mos_attr));
+			WriteCanvasCells (GetCanvas (img), cells, r.ULy, r.ULx);
+		}
+		else {
+			ReadCanvasCells (GetCanvas (img), cells, r.ULy, r.ULx);
+			memcpy (chars, cells->mosaic, Cells (r) * sizeof (mos_char));
+			memcpy (attrs, cells->attr, Cells (r) * sizeof (mos_attr));
+		}
+		FreeMOSAIC (cells);
+		return;
+	}
+
+	MOSAIC *m = img->img;
+	int y, i;
+	for (y = r.ULy, i = 0; y <= r.BRy; y++, i += width) {
+		const int at = MOS_INDEX (m, y, r.ULx);
+		if (backwards) {
+			memcpy (m->mosaic + at, chars + i, width * sizeof (mos_char));
+			memcpy (m->attr + at, attrs + i, width * sizeof (mos_attr));
+		}
+		else {
+			memcpy (chars + i, m->mosaic + at, width * sizeof (mos_char));
+			memcpy (attrs + i, m->attr + at, width * sizeof (mos_attr));
+		}
+	}
+}
+
+
+/// Aux function: does a contain b?
+static int Contains (Rect a, Rect b) {
+	return a.ULy <= b.ULy && b.BRy <= a.BRy
+			&& a.ULx <= b.ULx && b.BRx <= a.BRx;
+}
+
+
+void RecordRect (CURS_MOS *img, int ULy, int ULx, int BRy, int BRx) {
+	// a stowed canvas' view would be the whole image
+	Rect bounds = {0, 0, img->img->height - 1, img->img->width - 1};
+	if (StowedCanvas (img)) {
+		CanvasBounds (img, &bounds);
+	}
+	Rect r;
+	r.ULy = max (ULy, 0);
+	r.ULx = max (ULx, 0);
+	r.BRy = min (BRy, bounds.BRy);
+	r.BRx = min (BRx, bounds.BRx);
+	if (r.ULy > r.BRy || r.ULx > r.BRx) {
+		return;
+	}
+	history.edits++;
+	JournalRect (img, r.ULy, r.ULx, r.BRy, r.BRx);
+
+	Step *step = history.open;
+	// coalescing edits stay in the same step only while they're
+	// contiguous, like a typing run
+	if (step && step->coalescing && step->last && !step->last->whole) {
+		Rect last = step->last->rect;
+		if (!(last.ULy <= r.BRy + 1 && r.ULy <= last.BRy + 1
+					&& last.ULx <= r.BRx + 1 && r.ULx <= last.BRx + 1)) {
+			step = NULL;
+		}
+	}
+	if (!step || step->img != img || Moved (step)) {
+		step = OpenStep (img);
+	}
+
+	// already recorded: what's there now is part of this step
+	if (step->last && !step->last->whole && Contains (step->last->rect, r)) {
+		return;
+	}
+
+	Record *rec = (Record *) malloc (sizeof (Record));
+	rec->rect = r;
+	rec->whole = 0;
+	rec->canvas = NULL;
+	rec->chars = (mos_char *) malloc (Cells (r) * sizeof (mos_char));
+	rec->attrs = (mos_attr *) malloc (Cells (r) * sizeof (mos_attr));
+	CopyCells (img, r, rec->chars, rec->attrs, 0);
+	AddRecord (step, rec);
+}
+
+
+void RecordImage (CURS_MOS *img) {
+	UnstowCanvas (img);
+	history.edits++;
+	JournalWhole (img);
+	Step *step = history.open;
+	if (!step || step->img != img) {
+		step = OpenStep (img);
+	}
+	// nothing may be merged after a shape change
+	step->coalescing = 0;
+
+	Record *rec = (Record *) malloc (sizeof (Record));
+	rec->rect.ULy = rec->rect.ULx = 0;
+	rec->rect.BRy = img->img->height - 1;
+	rec->rect.BRx = img->img->width - 1;
+	rec->whole = 1;
+	rec->canvas = NULL;
+	rec->chars = (mos_char *) malloc (Cells (rec->rect) * sizeof (mos_char));
+	rec->attrs = (mos_attr *) malloc (Cells (rec->rect) * sizeof (mos_attr));
+	CopyCells (img, rec->rect, rec->chars, rec->attrs, 0);
+	AddRecord (step, rec);
+}
+
+
+void RecordCanvas (CURS_MOS *img) {
+	history.edits++;
+	JournalWhole (img);
+	Step *step = history.open;
+	if (!step || step->img != img || Moved (step)) {
+		step = OpenStep (img);
+	}
+	step->coalescing = 0;
+
+	Record *rec = (Record *) calloc (1, sizeof (Record));
+	rec->rect.BRy = img->img->height - 1;
+	rec->rect.BRx = img->img->width - 1;
+	rec->whole = 1;
+	rec->canvas = SnapshotCanvas (GetCanvas (img), 0);
+	AddRecord (step, rec);
+}
+
+
+/// Aux function: swaps a canvas record's snapshot with the canvas
+static void SwapCanvas (Step *step, Record *rec) {
+	CURS_MOS *img = step->img;
+	Rect now = {0, 0, img->img->height - 1, img->img->width - 1};
+
+	unDobox (img);
+	SwapSnapshot (GetCanvas (img), rec->canvas, rec->rect.BRy + 1,
+			rec->rect.BRx + 1);
+	rec->rect = now;
+	JournalWhole (img);
+	// the snapshot holds the other tiles: update the counts
+	Recount (step, rec);
+}
+
+
+/// Aux function: swaps a record's cells with the image's
+static void Swap (Step *step, Record *rec) {
+	history.edits++;
+	if (rec->canvas) {
+		SwapCanvas (step, rec);
+		return;
+	}
+	CURS_MOS *img = step->img;
+	// only whole images need the view: cells are swapped in the tiles
+	if (rec->whole) {
+		UnstowCanvas (img);
+	}
+	// what's in the image now is what the record will hold
+	Rect now = rec->rect;
+	if (rec->whole) {
+		now.BRy = img->img->height - 1;
+		now.BRx = img->img->width - 1;
+	}
+	mos_char *chars = (mos_char *) malloc (Cells (now) * sizeof (mos_char));
+	mos_attr *attrs = (mos_attr *) malloc (Cells (now) * sizeof (mos_attr));
+	CopyCells (img, now, chars, attrs, 0);
+
+	// whole images may have other dimensions
+	if (rec->whole) {
+		unDobox (img);
+		ResizeCURS_MOS (img, rec->rect.BRy + 1, rec->rect.BRx + 1);
+		ENTER_(REDRAW);
+		// the record will hold the other dimensions: update the counts
+		size_t bytes = (Cells (now) - Cells (rec->rect))
+				* (sizeof (mos_char) + sizeof (mos_attr));
+		step->bytes += bytes;
+		history.bytes += bytes;
+	}
+	CopyCells (img, rec->rect, rec->chars, rec->attrs, 1);
+	if (rec->whole) {
+		// an ordinary image then, a canvas now (it was duplicated): the
+		// tiles take it all
+		FitCanvas (img);
+		JournalWhole (img);
+	}
+	else {
+		JournalRect (img, rec->rect.ULy, rec->rect.ULx, rec->rect.BRy, rec->rect.BRx);
+	}
+	if (StowedCanvas (img)) {
+		// no pad to rewrite, but it may show through the current image
+		OnionDirty (img, rec->rect.ULy, rec->rect.ULx, rec->rect.BRy,
+				rec->rect.BRx);
+	}
+	else {
+		MarkDirty (img, rec->rect.ULy, rec->rect.ULx, rec->rect.BRy,
+				rec->rect.BRx);
+	}
+
+	free (rec->chars);
+	free (rec->attrs);
+	rec->chars = chars;
+	rec->attrs = attrs;
+	rec->rect = now;
+}
+
+
+CURS_MOS *Undo () {
+	Step *step = history.top;
+	if (!step) {
+		return NULL;
+	}
+
+	// joined steps go too, back to the first of them
+	do {
+		step = history.top;
+		ShowStep (step);
+		// backwards, so the oldest values are the ones left
+		Record *rec;
+		for (rec = step->last; rec; rec = rec->prev) {
+			Swap (step, rec);
+		}
+		history.top = step->prev;
+	} while (step->joined && history.top);
+
+	history.open = NULL;
+	return step->img;
+}
+
+
+CURS_MOS *Redo () {
+	Step *step = history.top ? history.top->next : history.first;
+	if (!step) {
+		return NULL;
+	}
+
+	// the first step's image, as Undo of them all would give
+	CURS_MOS *img = step->img;
+	// and the ones joined to it too
+	do {
+		ShowStep (step);
+		Record *rec;
+		for (rec = step->first; rec; rec = rec->next) {
+			Swap (step, rec);
+		}
+		history.top = step;
+		step = step->next;
+	} while (step && step->joined);
+
+	history.open = NULL;
+	return img;
+}
+
+
+void ForgetHistory (CURS_MOS *img) {
+	// only done when img changes in ways that can't be undone
+	history.edits++;
+	JournalWhole (img);
+	Step *step, *aux;
+	for (step = history.first; step; step = aux) {
+		aux = step->next;
+		if (step->img != img) {
+			continue;
+		}
+
+		if (step->prev) {
+			step->prev->next = step->next;
+		}
+		else {
+			history.first = step->next;
+		}
+		if (step->next) {
+			step->next->prev = step->prev;
+		}
+		if (history.top == step) {
+			history.top = step->prev;
+		}
+		if (history.open == step) {
+			history.open = NULL;
+		}
+		// the next joined one is first now
+		if (step->next && step->next->joined && !step->joined) {
+			step->next->joined = 0;
+			if (history.group == step) {
+				history.group = step->next;
+			}
+		}
+		else if (history.group == step) {
+			history.group = NULL;
+		}
+		FreeStep (step);
+	}
+}
+
+
+unsigned long EditCount () {
+	return history.edits;
+}
+
+
+void DestroyHistory () {
+	FreeSteps (history.first);
+	history.first = history.top = history.open = history.group = NULL;
+}
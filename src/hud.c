@@ -26,7 +26,7 @@ void ReHud () {
 }
 
 
-void UpdateHud (Cursor cur, Direction dir) {
+void UpdateHud (CURS_MOS *current, Cursor cur, Direction dir) {
 	int arrow;
 	// arrows, to show the direction!
 	switch (dir) {
@@ -61,12 +61,15 @@ void UpdateHud (Cursor cur, Direction dir) {
 		wattron (hud, A_BOLD);
 		mvwaddch (hud, 0, COLS - HUD_CURSOR_X + 2, 'T');
 	}
-	// update coordinates
+	// update coordinates; in canvases, the ones in the whole image
+	Rect bounds;
+	CanvasBounds (current, &bounds);
 	wstandend (hud);
-	mvwprintw (hud, 0, COLS - HUD_CURSOR_X + 4, "%dx%d", cur.y, cur.x);
+	mvwprintw (hud, 0, COLS - HUD_CURSOR_X + 4, "%dx%d",
+			cur.y - bounds.ULy, cur.x - bounds.ULx);
 	mvwaddch (hud, 0, COLS - 1, arrow);
-	wrefresh (hud);
-	move (cur.y % MOSAIC_PAD_HEIGHT, cur.x % MOSAIC_PAD_WIDTH);
+	wnoutrefresh (hud);
+	move (cur.y - current->y, cur.x - current->x);
 }
 
 
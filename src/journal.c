@@ -0,0 +1,476 @@
+#include "journal.h"
+#include "maae.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Bytes before the records
+#define HEADER_SIZE 32
+/// Bytes before a record's cells
+#define RECORD_HEADER_SIZE 16
+/// Bytes per cell in a record: the char, then the attribute
+#define CELL_SIZE 5
+/// Changed rectangles tracked per image; past them, it's a checkpoint
+#define MAX_JOURNAL_RECTS 4096
+
+/// An image's journaling state
+typedef struct journal {
+	CURS_MOS *img;	///< the image
+	char *file;	///< the checkpoint; NULL if there's none (or it's being written)
+	unsigned char header[HEADER_SIZE];	///< the header of it's journal
+	off_t logged;	///< the journal's size, as img left it; 0 if there's none
+	Rect *rects;	///< cells changed since the checkpoint; in the canvas,
+	                ///< for canvases
+	int n_rects;	///< how many rectangles there are
+	int size;	///< how many fit in rects
+	char whole;	///< was it changed in ways rectangles can't tell?
+	struct journal *next;
+} Journal;
+
+/// The journaling state
+static struct {
+	size_t limit;	///< the journal size limit; 0 for no journaling
+	Journal *first;	///< every image's state
+} journals = {(size_t) DEFAULT_JOURNAL_KB * 1024, NULL};
+
+
+/// Aux function: writes value's size low bytes, little-endian
+static void PutValue (unsigned char *out, uint64_t value, int size) {
+	int i;
+	for (i = 0; i < size; i++) {
+		out[i] = (value >> (8 * i)) & 0xff;
+	}
+}
+
+
+/// Aux function: reads a size bytes little-endian value
+static uint64_t GetValue (const unsigned char *in, int size) {
+	uint64_t value = 0;
+	int i;
+	for (i = size - 1; i >= 0; i--) {
+		value = (value << 8) | in[i];
+	}
+	return value;
+}
+
+
+/**
+ * Aux function: the header a journal of the checkpoint, as it is now, has
+ *
+ * @return 0, or the errno of a failed stat
+ */
+static int MakeHeader (const char *file_name, unsigned char *header) {
+	struct stat st;
+	if (stat (file_name, &st)) {
+		return errno;
+	}
+	memset (header, 0, HEADER_SIZE);
+	memcpy (header, "MOSJ", 4);
+	header[4] = JOURNAL_VERSION;
+	PutValue (header + 8, st.st_size, 8);
+	PutValue (header + 16, st.st_mtim.tv_sec, 8);
+	PutValue (header + 24, st.st_mtim.tv_nsec, 4);
+	return 0;
+}
+
+
+/// Aux function: the checkpoint's journal name; free it after use
+static char *JournalName (const char *file_name) {
+	char *name = (char *) malloc (strlen (file_name) + sizeof (JOURNAL_SUFFIX));
+	strcpy (name, file_name);
+	strcat (name, JOURNAL_SUFFIX);
+	return name;
+}
+
+
+/**
+ * Aux function: opens the checkpoint's journal, if it belongs to it
+ *
+ * @return The journal, positioned at the first record, or NULL if there's
+ * none (or it's from another version of the checkpoint)
+ */
+static FILE *OpenJournal (const char *file_name, const unsigned char *header) {
+	char *name = JournalName (file_name);
+	FILE *f = fopen (name, "rb");
+	free (name);
+	if (!f) {
+		return NULL;
+	}
+	unsigned char found[HEADER_SIZE];
+	if (fread (found, 1, HEADER_SIZE, f) != HEADER_SIZE
+			|| memcmp (found, header, HEADER_SIZE)) {
+		fclose (f);
+		return NULL;
+	}
+	return f;
+}
+
+
+/// Aux function: the size of the checkpoint's journal, 0 if it has none
+static off_t JournalSize (const char *file_name, const unsigned char *header) {
+	FILE *f = OpenJournal (file_name, header);
+	if (!f) {
+		return 0;
+	}
+	struct stat st;
+	const off_t size = fstat (fileno (f), &st) ? 0 : st.st_size;
+	fclose (f);
+	return size;
+}
+
+
+/// Aux function: gets img's state, creating it if asked to
+static Journal *FindJournal (CURS_MOS *img, char create) {
+	Journal *j;
+	for (j = journals.first; j; j = j->next) {
+		if (j->img == img) {
+			return j;
+		}
+	}
+	if (!create) {
+		return NULL;
+	}
+
+	j = (Journal *) calloc (1, sizeof (Journal));
+	j->img = img;
+	j->next = journals.first;
+	journals.first = j;
+	return j;
+}
+
+
+/// Aux function: forgets the changes tracked in j
+static void Clear (Journal *j) {
+	free (j->rects);
+	j->rects = NULL;
+	j->n_rects = j->size = 0;
+	j->whole = 0;
+}
+
+
+void SetJournalLimit (int kb) {
+	journals.limit = (size_t) kb * 1024;
+}
+
+
+/// Aux function: does a contain b?
+static int Contains (Rect a, Rect b) {
+	return a.ULy <= b.ULy && b.BRy <= a.BRy
+			&& a.ULx <= b.ULx && b.BRx <= a.BRx;
+}
+
+
+void JournalRect (CURS_MOS *img, int ULy, int ULx, int BRy, int BRx) {
+	if (!journals.limit) {
+		return;
+	}
+	Journal *j = FindJournal (img, 1);
+	if (j->whole) {
+		return;
+	}
+
+	Canvas *canvas = GetCanvas (img);
+	const int y = canvas ? canvas->y : 0, x = canvas ? canvas->x : 0;
+	Rect r = {ULy + y, ULx + x, BRy + y, BRx + x};
+	int i;
+	for (i = 0; i < j->n_rects; i++) {
+		if (Contains (j->rects[i], r)) {
+			return;
+		}
+	}
+	// runs of edits (typing, painting) grow the last rectangle
+	if (j->n_rects > 0) {
+		Rect *last = &j->rects[j->n_rects - 1];
+		if (last->ULy == r.ULy && last->BRy == r.BRy
+				&& r.ULx <= last->BRx + 1 && last->ULx <= r.BRx + 1) {
+			last->ULx = min (last->ULx, r.ULx);
+			last->BRx = max (last->BRx, r.BRx);
+			return;
+		}
+		if (last->ULx == r.ULx && last->BRx == r.BRx
+				&& r.ULy <= last->BRy + 1 && last->ULy <= r.BRy + 1) {
+			last->ULy = min (last->ULy, r.ULy);
+			last->BRy = max (last->BRy, r.BRy);
+			return;
+		}
+	}
+
+	// too scattered: rewriting everything is as good
+	if (j->n_rects == MAX_JOURNAL_RECTS) {
+		JournalWhole (img);
+		return;
+	}
+	if (j->n_rects == j->size) {
+		j->size = j->size ? 2 * j->size : 16;
+		j->rects = (Rect *) realloc (j->rects, j->size * sizeof (Rect));
+	}
+	j->rects[j->n_rects++] = r;
+}
+
+
+void JournalWhole (CURS_MOS *img) {
+	if (!journals.limit) {
+		return;
+	}
+	Journal *j = FindJournal (img, 1);
+	Clear (j);
+	j->whole = 1;
+}
+
+
+void JournalAttach (CURS_MOS *img, const char *file_name) {
+	if (!journals.limit) {
+		return;
+	}
+	Journal *j = FindJournal (img, 1);
+	Clear (j);
+	free (j->file);
+	j->file = NULL;
+	if (MakeHeader (file_name, j->header) == 0) {
+		j->file = strdup (file_name);
+		j->logged = JournalSize (file_name, j->header);
+	}
+}
+
+
+void StartCheckpoint (CURS_MOS *img) {
+	if (!journals.limit) {
+		return;
+	}
+	Journal *j = FindJournal (img, 1);
+	Clear (j);
+	free (j->file);
+	j->file = NULL;
+}
+
+
+void EndCheckpoint (CURS_MOS *img, const char *file_name, int ret) {
+	if (ret) {
+		JournalWhole (img);
+		return;
+	}
+	// whatever it had is in the file now
+	char *name = JournalName (file_name);
+	remove (name);
+	free (name);
+
+	Journal *j = FindJournal (img, 0);
+	if (j) {
+		free (j->file);
+		j->file = NULL;
+		if (MakeHeader (file_name, j->header) == 0) {
+			j->file = strdup (file_name);
+			j->logged = 0;
+		}
+	}
+}
+
+
+/// Aux function: copies the cells at y/x from img (a canvas' view, maybe)
+static void ReadCells (CURS_MOS *img, MOSAIC *cells, int y, int x) {
+	Canvas *canvas = GetCanvas (img);
+	if (canvas) {
+		ReadCanvasCells (canvas, cells, y, x);
+		return;
+	}
+	int i;
+	for (i = 0; i < cells->height; i++) {
+		memcpy (cells->mosaic + (size_t) i * cells->width,
+				img->img->mosaic + MOS_INDEX (img->img, y + i, x),
+				cells->width * sizeof (mos_char));
+		memcpy (cells->attr + (size_t) i * cells->width,
+				img->img->attr + MOS_INDEX (img->img, y + i, x),
+				cells->width * sizeof (mos_attr));
+	}
+}
+
+
+/**
+ * Aux function: writes a record of the cells in r
+ *
+ * @return 0, or 1 if writing failed
+ */
+static int WriteRecord (FILE *f, CURS_MOS *img, Rect r) {
+	const int height = r.BRy - r.ULy + 1, width = r.BRx - r.ULx + 1;
+	const size_t cells = (size_t) height * width;
+	MOSAIC *rect = NewMOSAIC (height, width);
+	ReadCells (img, rect, r.ULy, r.ULx);
+
+	unsigned char *record = (unsigned char *) malloc (RECORD_HEADER_SIZE
+			+ cells * CELL_SIZE);
+	PutValue (record, r.ULy, 4);
+	PutValue (record + 4, r.ULx, 4);
+	PutValue (record + 8, height, 4);
+	PutValue (record + 12, width, 4);
+	unsigned char *chars = record + RECORD_HEADER_SIZE;
+	unsigned char *attrs = chars + cells;
+	size_t i;
+	for (i = 0; i < cells; i++) {
+		chars[i] = rect->mosaic[i];
+		PutValue (attrs + 4 * i, rect->attr[i], 4);
+	}
+	const size_t len = RECORD_HEADER_SIZE + cells * CELL_SIZE;
+	const int failed = fwrite (record, 1, len, f) != len;
+
+	free (record);
+	FreeMOSAIC (rect);
+	return failed;
+}
+
+
+int AppendJournal (CURS_MOS *img, const char *file_name) {
+	Journal *j = FindJournal (img, 0);
+	if (!journals.limit || !j || !j->file || j->whole
+			|| strcmp (j->file, file_name)) {
+		return ERR;
+	}
+	// the checkpoint and journal must be just as img left them
+	unsigned char header[HEADER_SIZE];
+	if (MakeHeader (file_name, header) || memcmp (header, j->header, HEADER_SIZE)
+			|| JournalSize (file_name, header) != j->logged) {
+		return ERR;
+	}
+
+	size_t bytes = j->logged ? j->logged : HEADER_SIZE;
+	int i;
+	for (i = 0; i < j->n_rects; i++) {
+		const Rect r = j->rects[i];
+		bytes += RECORD_HEADER_SIZE
+				+ (size_t) (r.BRy - r.ULy + 1) * (r.BRx - r.ULx + 1) * CELL_SIZE;
+	}
+	if (bytes > journals.limit) {
+		return ERR;
+	}
+	if (j->n_rects == 0) {
+		return 0;
+	}
+
+	char *name = JournalName (file_name);
+	FILE *f = fopen (name, j->logged ? "ab" : "wb");
+	if (!f) {
+		free (name);
+		return errno;
+	}
+	int failed = !j->logged && fwrite (header, 1, HEADER_SIZE, f) != HEADER_SIZE;
+	for (i = 0; i < j->n_rects && !failed; i++) {
+		failed = WriteRecord (f, img, j->rects[i]);
+	}
+	int ret = failed ? (errno ? errno : EIO) : 0;
+	if (fclose (f) && !ret) {
+		ret = errno;
+	}
+	// a record cut short would hide the ones appended after it
+	if (ret) {
+		if (j->logged) {
+			truncate (name, j->logged);
+		}
+		else {
+			remove (name);
+		}
+	}
+	free (name);
+
+	if (ret == 0) {
+		j->logged = bytes;
+		Clear (j);
+	}
+	return ret;
+}
+
+
+/// Aux function: where the replayed cells go
+typedef void (*CellsSink) (void *data, MOSAIC *cells, int y, int x);
+
+
+/**
+ * Aux function: replays the checkpoint's journal, if it has one, over an
+ * image of height by width; records that don't fit end the replay
+ */
+static void Replay (const char *file_name, int height, int width,
+		CellsSink sink, void *data) {
+	unsigned char header[HEADER_SIZE];
+	if (MakeHeader (file_name, header)) {
+		return;
+	}
+	FILE *f = OpenJournal (file_name, header);
+	if (!f) {
+		return;
+	}
+
+	unsigned char rec[RECORD_HEADER_SIZE];
+	unsigned char *buffer = NULL;
+	while (fread (rec, 1, RECORD_HEADER_SIZE, f) == RECORD_HEADER_SIZE) {
+		const uint64_t y = GetValue (rec, 4), x = GetValue (rec + 4, 4);
+		const uint64_t h = GetValue (rec + 8, 4), w = GetValue (rec + 12, 4);
+		if (h == 0 || w == 0 || y + h > (uint64_t) height
+				|| x + w > (uint64_t) width) {
+			break;
+		}
+		const size_t cells = h * w;
+		buffer = (unsigned char *) realloc (buffer, cells * CELL_SIZE);
+		if (fread (buffer, 1, cells * CELL_SIZE, f) != cells * CELL_SIZE) {
+			break;
+		}
+
+		MOSAIC *rect = NewMOSAIC (h, w);
+		size_t i;
+		for (i = 0; i < cells; i++) {
+			rect->mosaic[i] = buffer[i];
+			rect->attr[i] = GetValue (buffer + cells + 4 * i, 4);
+		}
+		sink (data, rect, y, x);
+		FreeMOSAIC (rect);
+	}
+	free (buffer);
+	fclose (f);
+}
+
+
+/// Aux function: CellsSink for MOSAICs
+static void PutCells (void *data, MOSAIC *cells, int y, int x) {
+	MOSAIC *img = (MOSAIC *) data;
+	int i;
+	for (i = 0; i < cells->height; i++) {
+		memcpy (img->mosaic + MOS_INDEX (img, y + i, x),
+				cells->mosaic + (size_t) i * cells->width,
+				cells->width * sizeof (mos_char));
+		memcpy (img->attr + MOS_INDEX (img, y + i, x),
+				cells->attr + (size_t) i * cells->width,
+				cells->width * sizeof (mos_attr));
+	}
+}
+
+
+/// Aux function: CellsSink for canvases
+static void PutCanvasCells (void *data, MOSAIC *cells, int y, int x) {
+	WriteCanvasCells ((Canvas *) data, cells, y, x);
+}
+
+
+void ReplayJournal (const char *file_name, MOSAIC *img) {
+	Replay (file_name, img->height, img->width, PutCells, img);
+}
+
+
+void ReplayJournalCanvas (const char *file_name, Canvas *canvas) {
+	Replay (file_name, canvas->tiles->height, canvas->tiles->width,
+			PutCanvasCells, canvas);
+}
+
+
+void DestroyJournals () {
+	Journal *j, *aux;
+	for (j = journals.first; j; j = aux) {
+		aux = j->next;
+		free (j->rects);
+		free (j->file);
+		free (j);
+	}
+	journals.first = NULL;
+}
@@ -11,6 +11,7 @@ void CursInit () {
 	noecho ();
 
 	set_escdelay (0);	// no need to wait for the Esc key (we don't use the meta modifier)
+	idlok (stdscr, TRUE);	// scrolling the view scrolls the terminal, no repaint
 
 	start_color ();	// Colors!
 	InitColors ();	// initialize all the colors -> color.c
@@ -57,14 +58,17 @@ int toUTF8 (int c) {
 
 
 void InitCopyBuffer (CopyBuffer *buffer) {
-	buffer->buff = NULL;
-	buffer->coordinates.x = buffer->coordinates.y = buffer->coordinates.origin_y = buffer->coordinates.origin_x = 0;
+	buffer->chars = NULL;
+	buffer->attrs = NULL;
+	buffer->height = buffer->width = 0;
 }
 
 
 void DestroyCopyBuffer (CopyBuffer *buffer) {
 	if (buffer != NULL) {
-		delwin (buffer->buff);
+		free (buffer->chars);
+		free (buffer->attrs);
+		InitCopyBuffer (buffer);
 	}
 }
 
@@ -73,14 +77,34 @@ void Copy (CopyBuffer *buffer, CURS_MOS *current, Cursor selection) {
 	// if there was something stored, bye bye
 	DestroyCopyBuffer (buffer);
 
-	// copy buffer is a copy of the entire window, since the
-	// curses implementation certainly is better than I would do =P
-	buffer->buff = dupwin (current->win);
-	// set it's coordinates, so we know what part the user want to copy
-	buffer->coordinates.origin_y = min (selection.y, selection.origin_y);
-	buffer->coordinates.origin_x = min (selection.x, selection.origin_x);
-	buffer->coordinates.y = abs (selection.y - selection.origin_y);
-	buffer->coordinates.x = abs (selection.x - selection.origin_x);
+	// the selection, clipped to the image
+	MOSAIC *img = current->img;
+	int ULy = min (selection.y, selection.origin_y);
+	int ULx = min (selection.x, selection.origin_x);
+	int BRy = max (selection.y, selection.origin_y);
+	int BRx = max (selection.x, selection.origin_x);
+	BRy = min (BRy, img->height - 1);
+	BRx = min (BRx, img->width - 1);
+	if (ULy > BRy || ULx > BRx) {
+		return;
+	}
+
+	// store only what's selected, one row at a time
+	buffer->height = BRy - ULy + 1;
+	buffer->width = BRx - ULx + 1;
+	buffer->chars = (mos_char *) malloc (buffer->height * buffer->width
+			* sizeof (mos_char));
+	buffer->attrs = (mos_attr *) malloc (buffer->height * buffer->width
+			* sizeof (mos_attr));
+	int i;
+	for (i = 0; i < buffer->height; i++) {
+		memcpy (buffer->chars + i * buffer->width,
+				img->mosaic + MOS_INDEX (img, ULy + i, ULx),
+				buffer->width * sizeof (mos_char));
+		memcpy (buffer->attrs + i * buffer->width,
+				img->attr + MOS_INDEX (img, ULy + i, ULx),
+				buffer->width * sizeof (mos_attr));
+	}
 }
 
 
@@ -88,45 +112,45 @@ void Cut (CopyBuffer *buffer, CURS_MOS *current, Cursor selection) {
 	// we copy to the buffer
 	Copy (buffer, current, selection);
 	// and erase what was in there
-	int i, j;
 	const int y = min (selection.y, selection.origin_y);	// we need the upper-left
 	const int x = min (selection.x, selection.origin_x);	// corner only
-	for (i = 0; i <= buffer->coordinates.y; i++) {
-		for (j = 0; j <= buffer->coordinates.x; j++) {
-			curs_mosSetCh (current, y + i, x + j, ' ');
-			curs_mosSetAttr (current, y + i, x + j, 0);
-		}
-	}
+	RecordRect (current, y, x, y + buffer->height - 1, x + buffer->width - 1);
+	FillRect (current->img, y, x, y + buffer->height - 1,
+			x + buffer->width - 1, ' ', 0, FILL_CH | FILL_ATTR);
+	MarkDirty (current, y, x, y + buffer->height - 1,
+			x + buffer->width - 1);
+}
+
+
+/// The key for transparent pasting: which cells leave the old ones there
+static BlitKey transparent_key = {BLIT_KEY_CELL, ' ', Normal};
+
+
+void SetTransparentKey (BlitKey key) {
+	transparent_key = key;
 }
 
 
 char Paste (CopyBuffer *buffer, CURS_MOS *current, Cursor cursor) {
-	if (buffer->buff != NULL) {
-		int i, j;
-		chtype c;
-		for (i = 0; i <= buffer->coordinates.y; i++) {
-			for (j = 0; j <= buffer->coordinates.x; j++) {
-				// read the char from the CopyBuffer
-				c = mvwinch (buffer->buff,
-						buffer->coordinates.origin_y + i,
-						buffer->coordinates.origin_x + j);
-				// if transparent pasting, and it's a ' ',
-				// leave the old char there
-				if (IS_(TRANSPARENT) && c == ' ') {
-					continue;
-				}
-				// if outside CURS_MOS window, don't try to put 'c' in it, or it'll crash
-				// so, SetCh and SetAttr in the target
-				else if (curs_mosSetCh (current,
-							cursor.y + i, cursor.x + j, c & A_CHARTEXT)
-						|| curs_mosSetAttr (current,
-							cursor.y + i, cursor.x + j, PAIR_NUMBER (c & A_COLOR)
-							| ((c & A_ATTRIBUTES & A_BOLD) ? BOLD : 0))) {
-					break;
-				}
-			}
+	if (buffer->chars != NULL) {
+		BlitSource src;
+		src.chars = buffer->chars;
+		src.attrs = buffer->attrs;
+		src.height = buffer->height;
+		src.width = src.stride = buffer->width;
+
+		BlitKey key = transparent_key;
+		if (!IS_(TRANSPARENT)) {
+			key.mode = BLIT_OPAQUE;
 		}
 
+		RecordRect (current, cursor.y, cursor.x,
+				cursor.y + src.height - 1, cursor.x + src.width - 1);
+		// Blit clips it, so nothing is written outside the image
+		Rect written = Blit (current->img, cursor.y, cursor.x, src, key);
+		MarkDirty (current, written.ULy, written.ULx,
+				written.BRy, written.BRx);
+
 		DisplayCurrent (current);
 		return 1;
 	}
@@ -136,6 +160,106 @@ char Paste (CopyBuffer *buffer, CURS_MOS *current, Cursor cursor) {
 }
 
 
+int EditImages (IMGS *everyone, CURS_MOS *current, Cursor cursor,
+		CopyBuffer *buffer, mos_attr attr) {
+	RangeEdit edit;
+	edit.rect.ULy = min (cursor.y, cursor.origin_y);
+	edit.rect.ULx = min (cursor.x, cursor.origin_x);
+	edit.rect.BRy = max (cursor.y, cursor.origin_y);
+	edit.rect.BRx = max (cursor.x, cursor.origin_x);
+	if (!IS_(SELECTION)) {
+		edit.rect.ULy = edit.rect.BRy = cursor.y;
+		edit.rect.ULx = edit.rect.BRx = cursor.x;
+	}
+	edit.attr = attr;
+
+	switch (PrintHud (TRUE, "In a range of images: Paste, Fill, Recolor or Erase? (p/f/r/e)")) {
+		case 'p': case 'P':
+			if (buffer->chars == NULL) {
+				PrintHud (FALSE, "Nothing in the buffer...");
+				return 0;
+			}
+			edit.op = RANGE_PASTE;
+			edit.rect.ULy = cursor.y;
+			edit.rect.ULx = cursor.x;
+			edit.src.chars = buffer->chars;
+			edit.src.attrs = buffer->attrs;
+			edit.src.height = buffer->height;
+			edit.src.width = edit.src.stride = buffer->width;
+			edit.key = transparent_key;
+			if (!IS_(TRANSPARENT)) {
+				edit.key.mode = BLIT_OPAQUE;
+			}
+			break;
+
+		case 'f': case 'F':
+			edit.op = RANGE_FILL;
+			edit.ch = PrintHud (TRUE, "Fill with which char?");
+			if (!isprint (edit.ch)) {
+				return 0;
+			}
+			break;
+
+		case 'r': case 'R':
+			edit.op = RANGE_RECOLOR;
+			break;
+
+		case 'e': case 'E':
+			edit.op = RANGE_ERASE;
+			break;
+
+		default:
+			return 0;
+	}
+
+	const int first = VPrintHud (SCAN, "From img (0~%d):", everyone->size - 1);
+	if (first == ERR) {
+		return 0;
+	}
+	const int last = VPrintHud (SCAN, "To img (%d~%d):", first, everyone->size - 1);
+	if (last == ERR) {
+		return 0;
+	}
+
+	int skipped;
+	const int edited = EditRange (everyone, current, first, last, &edit, 0,
+			&skipped);
+	if (edited == ERR) {
+		PrintHud (FALSE, "Invalid index");
+		return 0;
+	}
+	if (skipped > 0) {
+		VPrintHud (FALSE, "Edited %d images (%d canvases left out)", edited,
+				skipped);
+	}
+	else {
+		VPrintHud (FALSE, "Edited %d images", edited);
+	}
+	return edited;
+}
+
+
+WINDOW *CopyBufferPad (CopyBuffer *buffer) {
+	if (buffer->chars == NULL) {
+		return NULL;
+	}
+
+	WINDOW *pad = newpad (buffer->height, buffer->width);
+	chtype row[buffer->width];
+	int i, j;
+	for (i = 0; i < buffer->height; i++) {
+		for (j = 0; j < buffer->width; j++) {
+			const int k = i * buffer->width + j;
+			row[j] = (unsigned char) buffer->chars[k]
+					| CursesAttr (buffer->attrs[k]);
+		}
+		mvwaddchnstr (pad, i, 0, row, buffer->width);
+	}
+
+	return pad;
+}
+
+
 Cursor MoveSelection (CURS_MOS *current, Cursor position) {
 	// human readable variables
 	int ULy = min (position.origin_y, position.y);
@@ -158,8 +282,8 @@ Cursor MoveSelection (CURS_MOS *current, Cursor position) {
 
 	Cut (&copy, current, position);
 
-	// the panel we're going to move around
-	WINDOW *win = subpad (copy.buff, BRy - ULy + 1, BRx - ULx + 1, ULy, ULx);
+	// the pad we're going to move around
+	WINDOW *win = CopyBufferPad (&copy);
 
 	// input
 	int c;
@@ -172,7 +296,8 @@ Cursor MoveSelection (CURS_MOS *current, Cursor position) {
 			/* Mouse event: clicked the window, just move */
 			case KEY_MOUSE:
 				getmouse (&event);
-				MoveTo (&position, current, event.y, event.x);
+				MoveTo (&position, current, event.y + current->y,
+						event.x + current->x);
 				break;
 
 			/* move up */
@@ -198,10 +323,10 @@ Cursor MoveSelection (CURS_MOS *current, Cursor position) {
 
 		// first, display current img (which is behind)
 		DisplayCurrent (current);
-		// then our selection, respecting the current "block" (for mosaics bigger than the screen)
-		prefresh (win, 0, 0, position.y % MOSAIC_PAD_HEIGHT, position.x % MOSAIC_PAD_WIDTH,
-				min (current->img->height - (current->y * MOSAIC_PAD_HEIGHT) - 1, MOSAIC_PAD_HEIGHT) - 1,
-				min (current->img->width - (current->x * MOSAIC_PAD_WIDTH) - 1, MOSAIC_PAD_WIDTH) - 1);
+		// then our selection, respecting the view (for mosaics bigger than the screen)
+		prefresh (win, 0, 0, position.y - current->y, position.x - current->x,
+				min (current->img->height - current->y - 1, MOSAIC_PAD_HEIGHT) - 1,
+				min (current->img->width - current->x - 1, MOSAIC_PAD_WIDTH) - 1);
 	} while (c != KEY_ESC && c != '\n');
 
 	// canceled, let's go back to original position
@@ -237,26 +362,25 @@ CURS_MOS *CreateNewMOSAIC (IMGS *everyone, CURS_MOS *current) {
 		return NULL;
 	}
 
-	CURS_MOS *new_image = NewCURS_MOS (height, width);
-
-	// copy if asked for a duplicate
-	if (duplicate) {
-		CopyMOSAIC (new_image->img, current->img);
-		ENTER_(REDRAW);
+	CURS_MOS *new_image;
+	// duplicates share the tiles, copy-on-write: ordinary images become
+	// canvases to share them
+	if (duplicate && current) {
+		new_image = DuplicateCanvas (MakeCanvas (current));
+		// the pad is written when it's shown
+		MarkAllDirty (new_image);
 	}
-
-	// now there's one more CURS_MOS
-	everyone->size++;
-
-	// first image: no one's after or before
-	if (everyone->list == NULL) {
-		CircularIMGS (everyone, new_image);
+	// too big to be kept whole: make it a canvas
+	else if (height > MAX_DENSE_SIDE || width > MAX_DENSE_SIDE) {
+		new_image = NewCanvas (height, width);
 	}
-	// not the first, so link it to someone
 	else {
-		LinkCURS_MOS (current, new_image, dir);
+		new_image = NewCURS_MOS (height, width);
 	}
 
+	// now there's one more CURS_MOS
+	AddPage (everyone, current, new_image, dir);
+
 	DisplayCurrent (new_image);
 
 	return new_image;
@@ -264,12 +388,22 @@ CURS_MOS *CreateNewMOSAIC (IMGS *everyone, CURS_MOS *current) {
 
 
 void Resize (CURS_MOS *current, Cursor *cursor) {
-	int height = current->img->height;
-	int width = current->img->width;
+	Rect bounds;
+	CanvasBounds (current, &bounds);
+	int height = bounds.BRy - bounds.ULy + 1;
+	int width = bounds.BRx - bounds.ULx + 1;
 
 	if (AskResizeMOSAIC (&height, &width) != ERR) {
 		ClearWin (current);
-		ResizeCURS_MOS (current, height, width);
+		// canvases stay canvases, and too big images become one
+		if (GetCanvas (current) || height > MAX_DENSE_SIDE
+				|| width > MAX_DENSE_SIDE) {
+			ResizeCanvas (current, height, width);
+		}
+		else {
+			RecordImage (current);
+			ResizeCURS_MOS (current, height, width);
+		}
 		// move to inside the resized MOSAIC
 		MoveResized (cursor, current);
 		ENTER_(REDRAW);
@@ -278,11 +412,36 @@ void Resize (CURS_MOS *current, Cursor *cursor) {
 
 
 void DisplayCurrent (CURS_MOS *current) {
+	// another image, or other images under it: the onion skin is all new
+	if (UpdateOnion (current)) {
+		ENTER_(REDRAW);
+	}
 	// things we don't always need to worry about
 	if (IS_(REDRAW)) {
 		dobox (current);
 		RewriteCURS_MOS (current);
-		UN_(REDRAW);
+		OverlayOnion (current);
+		// everything was rewritten, dirty or not
+		DiscardDirty (current);
+		// the rewrite wiped the selection box from the pad
+		ReprintSelection (current);
+		UN_(REDRAW | REBORDER);
+	}
+	else {
+		// scrolled: the pad must be copied again
+		if (IS_(REBORDER)) {
+			dobox (current);
+			touchwin (current->win);
+			UN_(REBORDER);
+		}
+		// rewrite only what was edited since the last display
+		if (FlushDirty () && IS_(SELECTION)) {
+			ReprintSelection (current);
+		}
+	}
+	// selection retracted (by a fill, maybe): take the box off the pad
+	if (!IS_(SELECTION)) {
+		UnprintSelection (current);
 	}
 	DisplayCurrentMOSAIC (current);
 }
@@ -299,8 +458,8 @@ void ClearWin (CURS_MOS *current) {
 
 
 void dobox (CURS_MOS *img) {
-	int y = img->img->height - (img->y * MOSAIC_PAD_HEIGHT);
-	int x = img->img->width - (img->x * MOSAIC_PAD_WIDTH);
+	int y = img->img->height - img->y;
+	int x = img->img->width - img->x;
 
 	// lines
 	if (x < MOSAIC_PAD_WIDTH) {
@@ -316,7 +475,8 @@ void dobox (CURS_MOS *img) {
 		mvaddch (y, x, ACS_LRCORNER);
 	}
 
-	refresh ();
+	// staged only, the frame's doupdate sends it
+	wnoutrefresh (stdscr);
 }
 
 
@@ -345,11 +505,9 @@ void ChAttrs (CURS_MOS *current, Cursor *cur, mos_attr attr) {
 		int BRy = max (cur->origin_y, cur->y);
 		int BRx = max (cur->origin_x, cur->x);
 
-		for (y = ULy; y <= BRy; y++) {
-			for (x = ULx; x <= BRx; x++) {
-				curs_mosSetAttr (current, y, x, attr);
-			}
-		}
+		RecordRect (current, ULy, ULx, BRy, BRx);
+		FillRect (current->img, ULy, ULx, BRy, BRx, 0, attr, FILL_ATTR);
+		MarkDirty (current, ULy, ULx, BRy, BRx);
 
 		// Retract selection
 		UN_(SELECTION);
@@ -362,7 +520,9 @@ void ChAttrs (CURS_MOS *current, Cursor *cur, mos_attr attr) {
 		// normal insertion
 		y = cur->y;
 		x = cur->x;
-		curs_mosSetAttr (current, y, x, attr);
+		RecordRect (current, y, x, y, x);
+		mosSetAttr (current->img, y, x, attr);
+		MarkDirty (current, y, x, y, x);
 	}
 }
 
@@ -379,12 +539,10 @@ void InsertCh (CURS_MOS *current, Cursor *cur, int c, mos_attr attr,
 		int BRy = max (cur->origin_y, cur->y);
 		int BRx = max (cur->origin_x, cur->x);
 
-		for (y = ULy; y <= BRy; y++) {
-			for (x = ULx; x <= BRx; x++) {
-				curs_mosSetCh (current, y, x, c);
-				curs_mosSetAttr (current, y, x, attr);
-			}
-		}
+		RecordRect (current, ULy, ULx, BRy, BRx);
+		FillRect (current->img, ULy, ULx, BRy, BRx, c, attr,
+				FILL_CH | FILL_ATTR);
+		MarkDirty (current, ULy, ULx, BRy, BRx);
 
 		// Retract selection
 		UN_(SELECTION);
@@ -398,107 +556,256 @@ void InsertCh (CURS_MOS *current, Cursor *cur, int c, mos_attr attr,
 	// insert mode: need to push everyone one char in dir
 	else  {
 		if (IS_(INSERT)) {
-			// moving coordinate and the stop point (cur->x or cur->y)
-			// 	note that moving is just a reference to the moving variable,
-			// 	so that we don't need to know which one is the moving one at
-			// 	the verification
-			int *moving, end;
-			switch (dir) {
-				case UP:
-					y = 0;
-					moving = &y;
-					end = cur->y;
-					break;
-
-				case DOWN:
-					y = current->img->height;
-					moving = &y;
-					end = cur->y;
-					break;
-
-				case LEFT:
-					x = 0;
-					moving = &x;
-					end = cur->x;
-					break;
-
-				case RIGHT:
-					x = current->img->width;
-					moving = &x;
-					end = cur->x;
-					break;
-
-				default:
-					moving = &y;
-					end = cur->y;
-			}
-
-			while (*moving != end) {
-				// update target_y/target_x: where we'll put the copied chars
-				int target_y = y;
-				int target_x = x;
-				// go in reverse moving the chars
-				switch (REVERSE (dir)) {
-					case UP:	--y;	break;
-					case DOWN:	++y;	break;
-					case LEFT:	--x;	break;
-					case RIGHT:	++x;	break;
-				}
-				// read next char
-				mos_char aux = _curs_mosGetCh (current, y, x);
-				mos_attr aux_attr = _curs_mosGetAttr (current, y, x);
-				// add it in it's new place
-				curs_mosSetCh (current, target_y, target_x, aux);
-				curs_mosSetAttr (current, target_y, target_x, aux_attr);
-			}
-
-			// redraw WINDOW
-			RewriteCURS_MOS (current);
+			// the changed line: from y/x to the border in dir
+			Rect line;
+			line.ULy = dir == UP ? 0 : y;
+			line.ULx = dir == LEFT ? 0 : x;
+			line.BRy = dir == DOWN ? current->img->height - 1 : y;
+			line.BRx = dir == RIGHT ? current->img->width - 1 : x;
+			RecordRect (current, line.ULy, line.ULx, line.BRy, line.BRx);
+			// push everyone in the line one cell in dir, in block copies...
+			ShiftLine (current->img, y, x, dir);
+			// ...so that only this line needs to be rewritten
+			MarkDirty (current, line.ULy, line.ULx, line.BRy, line.BRx);
 		}
 		// normal insertion
-		curs_mosSetCh (current, y, x, c);
-		curs_mosSetAttr (current, y, x, attr);
+		RecordRect (current, y, x, y, x);
+		mosSetCh (current->img, y, x, c);
+		mosSetAttr (current->img, y, x, attr);
+		MarkDirty (current, y, x, y, x);
 	}
 }
 
 
-int Load (CURS_MOS *current) {
+int Load (IMGS *everyone, CURS_MOS **current) {
 	char *file_name = AskSaveLoadMOSAIC (load);
 
 	// if user canceled
 	if (!file_name) {
 		return ERR;
 	}
+	// videos are new images, after the current
+	else if (IsVideo (file_name)) {
+		const int size = everyone->size;
+		CURS_MOS *first = NULL;
+		const int ret = LoadVideo (everyone, *current, file_name, &first);
+		if (first) {
+			*current = first;
+		}
+		VPrintHud (ret != 0, ret ? "Sorry, loaded only %d frames... =/"
+				: "Loaded %d frames!", everyone->size - size);
+		return ret;
+	}
 	else {
-		return LoadCURS_MOS (current, file_name);
+		return StartLoad (*current, file_name);
 	}
 }
 
 
-int Save (CURS_MOS *current) {
+int LoadAnyCURS_MOS (CURS_MOS *current, const char *file_name) {
+	if (!IsBinary (file_name)) {
+		const int ret = LoadCURS_MOS (current, file_name);
+		if (LoadedChars (ret)) {
+			ReplayJournal (file_name, current->img);
+			ENTER_(REDRAW);
+		}
+		return ret;
+	}
+
+	BinaryFile file;
+	int ret = OpenBinary (&file, file_name);
+	if (ret) {
+		return ret;
+	}
+	// too big to be decoded at once: mapped in a canvas, and decoded as
+	// the view reaches it
+	if (file.height > MAX_DENSE_SIDE || file.width > MAX_DENSE_SIDE) {
+		CloseBinary (&file);
+		return LoadCanvas (MakeCanvas (current), file_name);
+	}
+	ResizeCURS_MOS (current, file.height, file.width);
+	MOSAIC *img = current->img;
+	int y;
+	for (y = 0; y < file.height && !ret; y++) {
+		ret = ReadBinaryRow (&file, y, img->mosaic + (size_t) y * img->width,
+				img->attr + (size_t) y * img->width);
+	}
+	CloseBinary (&file);
+	if (ret == 0) {
+		ReplayJournal (file_name, img);
+	}
+	// the pad is rewritten from the image
+	ENTER_(REDRAW);
+
+	return ret;
+}
+
+
+/// EditCount when the background save started: edits made after it
+/// aren't in the file
+static unsigned long saved_edits = 0;
+
+
+int Save (IMGS *everyone, CURS_MOS *current) {
 	char *file_name = AskSaveLoadMOSAIC (save);
 
 	if (!file_name) {
 		return ERR;
 	}
+	// every image goes in a video, right now
+	else if (VideoName (file_name)) {
+		if (SaveVideo (everyone, file_name)) {
+			PrintHud (TRUE, "Sorry, no can save this... =/");
+			return ERR;
+		}
+		VPrintHud (FALSE, "Saved %d frames!", everyone->size);
+		UN_(TOUCHED);
+		return 0;
+	}
 	else {
-		if (!strstr (file_name, ".mosi")) {
+		if (!strstr (file_name, ".mosi") && !BinaryName (file_name)) {
 			strcat (file_name, ".mosi");
 		}
 
-		return SaveCURS_MOS (current, file_name);
+		// the file has everything but the last changes: append just them
+		if (AppendJournal (current, file_name) == 0) {
+			PrintHud (FALSE, "Saved successfully!");
+			UN_(TOUCHED);
+			return 0;
+		}
+		// the blanks would take the corrupted rows' place for good
+		if (OverwritesCorrupted (current, file_name)) {
+			PrintHud (TRUE, "This file has corrupted rows: save it with another name");
+			return ERR;
+		}
+		saved_edits = EditCount ();
+		return StartSave (current, file_name);
 	}
 }
 
 
-void EraseLine (CURS_MOS *current) {
-	// just take the greater, so we don't need to worry about the direction
-	int i = max (current->img->height, current->img->width);
+/// Aux function: shows how far the background job is
+static void ShowFileIOProgress () {
+	static int spin = 0;
+	const char *doing = AsyncRunning () == ASYNC_SAVE ? "Saving" : "Loading";
+	const int progress = AsyncProgress ();
+	if (progress >= 0) {
+		VPrintHud (FALSE, "%s %s... %d%%", doing, AsyncFile (), progress);
+	}
+	// no way to know: just show it's alive
+	else {
+		VPrintHud (FALSE, "%s %s... %c", doing, AsyncFile (), "|/-\\"[spin++ % 4]);
+	}
+}
+
 
-	while (i > 0 && i--) {
-		// let main's erasure work it's magic
-		ungetch (KEY_BACKSPACE);
+void PollFileIO (CURS_MOS *current, Cursor *cursor) {
+	AsyncKind kind;
+	CURS_MOS *target;
+	const int ret = FinishAsync (&kind, &target);
+	if (ret == ERR) {
+		if (AsyncRunning ()) {
+			ShowFileIOProgress ();
+		}
+		return;
+	}
+
+	if (kind == ASYNC_SAVE) {
+		if (ret == 0) {
+			PrintHud (FALSE, "Saved successfully!");
+			// nothing changed while it was saving: it's all in the file
+			if (EditCount () == saved_edits) {
+				UN_(TOUCHED);
+			}
+		}
+		else {
+			PrintHud (TRUE, "Sorry, no can save this... =/");
+		}
+		return;
+	}
+
+	switch (ret) {
+		case 0:
+			PrintHud (FALSE, "Loaded successfully!");
+			ENTER_(TOUCHED | REDRAW);
+			break;
+
+		case ENOENT:
+			PrintHud (TRUE, "File doesn't exist");
+			break;
+
+		case ENODIMENSIONS:
+			PrintHud (TRUE, "No dimensions in this file, dude! =/");
+			break;
+
+		case EUNKNSTRGFMT:
+			PrintHud (TRUE, "Sorry, couldn't load attributes...");
+			break;
+
+		default:
+			PrintHud (TRUE, "Sorry, no can load this... =/");
+			break;
+	}
+	// the image may have changed size under the cursor
+	if (target == current) {
+		MoveResized (cursor, current);
+	}
+}
+
+
+void EraseSpan (Cursor *cursor, CURS_MOS *current, Direction dir, int n) {
+	// in selection mode Backspace just blanks the selection
+	if (IS_(SELECTION)) {
+		InsertCh (current, cursor, ' ', Normal, dir);
+		return;
+	}
+	if (n <= 0) {
+		return;
+	}
+
+	// one step in dir
+	int dy = 0, dx = 0;
+	switch (dir) {
+		case UP:	dy = -1;	break;
+		case DOWN:	dy = 1;		break;
+		case LEFT:	dx = -1;	break;
+		case RIGHT:	dx = 1;		break;
 	}
+
+	// where the run ends: Backspace stops at the border
+	int end_y = cursor->y + dy * n;
+	int end_x = cursor->x + dx * n;
+	end_y = max (end_y, 0);
+	end_x = max (end_x, 0);
+	end_y = min (end_y, current->img->height - 1);
+	end_x = min (end_x, current->img->width - 1);
+
+	// and where it starts: the cell before the cursor, unless we're at
+	// the border already, where Backspace erases right there
+	int start_y = cursor->y, start_x = cursor->x;
+	if (start_y != end_y || start_x != end_x) {
+		start_y += dy;
+		start_x += dx;
+	}
+
+	// blank the whole run in one pass
+	int ULy = min (start_y, end_y);
+	int ULx = min (start_x, end_x);
+	int BRy = max (start_y, end_y);
+	int BRx = max (start_x, end_x);
+	RecordRect (current, ULy, ULx, BRy, BRx);
+	FillRect (current->img, ULy, ULx, BRy, BRx, ' ', Normal,
+			FILL_CH | FILL_ATTR);
+	MarkDirty (current, ULy, ULx, BRy, BRx);
+
+	MoveTo (cursor, current, end_y, end_x);
+}
+
+
+void EraseLine (Cursor *cursor, CURS_MOS *current, Direction dir) {
+	// just take the greater, so we don't need to worry about the direction
+	EraseSpan (cursor, current, dir,
+			max (current->img->height, current->img->width));
 }
 
 
@@ -522,10 +829,7 @@ void EraseWord (Cursor *cursor, CURS_MOS *current, Direction dir) {
 		i++;
 	} while (c != ' ' && c);
 
-	while (i > 0 && i--) {
-		// let main's erasure work it's magic for the counted chars
-		ungetch (KEY_BACKSPACE);
-	}
+	EraseSpan (cursor, current, dir, i);
 }
 
 
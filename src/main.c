@@ -1,9 +1,29 @@
 #include "maae.h"
 #include "argpstuff.h"
+#include "frame.h"
+#include "export.h"
 
 int main (int argc, char *argv[]) {
-	const char *file_name = arguments (argc, argv);
+	struct arguments args;
+	arguments (argc, argv, &args);
+	const char *file_name = args.input;
+	// batch: convert every file, no curses at all
+	if (args.batch != BATCH_NONE) {
+		return Batch (args.batch, args.inputs, args.n_inputs,
+				args.output_dir, args.jobs);
+	}
+	// headless: just print the file, no curses at all
+	if (args.dimensions || args.color) {
+		return Headless (file_name, args.dimensions, args.color);
+	}
 	CursInit ();
+	SetMaxFrameRate (args.max_fps);
+	SetTransparentKey (args.transparent_key);
+	SetHistoryLimit (args.history_kb);
+	SetScrollMargin (args.scroll_margin);
+	SetAutosaveInterval (args.autosave);
+	SetJournalLimit (args.journal_kb);
+	SetPlayRate (args.play_fps);
 	
 	// initialize stuff
 	//  cursor
@@ -30,14 +50,20 @@ int main (int argc, char *argv[]) {
 	CURS_MOS *current = NULL;
 	// we really need a current image, so ask for it until user creates it!
 	// but if asked to open a file in argv, creates an empty MOSAIC and loads it
-	if (file_name) {
+	// (or one for each frame, for videos)
+	if (file_name && IsVideo (file_name)) {
+		LoadVideo (&everyone, NULL, file_name, &current);
+		InitSaveLoadMOSAIC (file_name);
+	}
+	else if (file_name) {
 		current = NewCURS_MOS (0, 0);
 		// try to load...
-		int load_return = LoadCURS_MOS (current, file_name);
+		int load_return = LoadAnyCURS_MOS (current, file_name);
 		// ... it may be alright...
-		if (load_return == 0 || load_return == EUNKNSTRGFMT) {
-			CircularIMGS (&everyone, current);
+		if (LoadedChars (load_return)) {
+			AddPage (&everyone, NULL, current, after);
 			InitSaveLoadMOSAIC (file_name);
+			JournalAttach (current, file_name);
 		}
 		// ...but it might go wrong
 		else {
@@ -45,6 +71,23 @@ int main (int argc, char *argv[]) {
 			current = NULL;
 		}
 	}
+	// a crashed session left images behind: bring them back?
+	const int recoverable = RecoverableImages ();
+	if (recoverable > 0) {
+		char question[80];
+		snprintf (question, sizeof (question),
+				"Recover %d image(s) from a crashed session?", recoverable);
+		if (AskMessage (question)) {
+			CURS_MOS *recovered = RecoverImages (&everyone, current);
+			if (recovered) {
+				current = current ? current : recovered;
+				ENTER_(TOUCHED);
+			}
+		}
+		else {
+			DiscardRecovery ();
+		}
+	}
 	while (!current) {
 		current = CreateNewMOSAIC (&everyone, current);
 	}
@@ -55,6 +98,9 @@ int main (int argc, char *argv[]) {
 		if (c == KEY_F(10)) {
 			c = Menu ();
 		}
+		// where we were, for paint mode to know if the cursor moved
+		const Cursor last_cursor = cursor;
+		CURS_MOS *const last_current = current;
 
 		switch (c) {
 			/* if nothing is returned by the menu, do nothing */
@@ -80,7 +126,8 @@ int main (int argc, char *argv[]) {
 					break;
 				}
 				// bt1: move to mouse anyway
-				MoveTo (&cursor, current, event.y, event.x);
+				MoveTo (&cursor, current, event.y + current->y,
+						event.x + current->x);
 				break;
 				
 			/* move up */
@@ -111,23 +158,35 @@ int main (int argc, char *argv[]) {
 			/* previous mosaic */
 			case KEY_PPAGE:
 				current = current->prev;
-				current_index = current_index - 1;
-				if (current_index < 0) {
-					current_index = everyone.size - 1;
-				}
+				current_index = PageIndex (&everyone, current);
 				VPrintHud (FALSE, "img %d", current_index);
 				break;
 				
 			/* next mosaic */
 			case KEY_NPAGE:
 				current = current->next;
-				current_index = current_index + 1;
-				if (current_index >= everyone.size) {
-					current_index = 0;
-				}
+				current_index = PageIndex (&everyone, current);
 				VPrintHud (FALSE, "img %d", current_index);
 				break;
 
+			/* play the images as an animation, until a key is pressed */
+			case KEY_F(5):
+				{
+					PlayStats stats;
+					current = Play (&everyone, current, &stats);
+					current_index = PageIndex (&everyone, current);
+					// the frames were drawn over the pad: copy it again
+					ENTER_(REBORDER);
+					VPrintHud (FALSE, "img %d. Played %d frames, %d dropped",
+							current_index, stats.shown, stats.dropped);
+				}
+				break;
+
+			/* toggle the onion skin */
+			case KEY_F(6):
+				InformToggleState (ONION, "Onion skin ON", "Onion skin OFF");
+				break;
+
 			/* go to page */
 			case KEY_CTRL_G:
 				{
@@ -168,8 +227,10 @@ int main (int argc, char *argv[]) {
 				{
 					CURS_MOS *aux = CreateNewMOSAIC (&everyone, current);
 					// aux was really created, so update the current curs_mos
+					// (linked before, it pushes the ones after it forward)
 					if (aux) {
 						current = aux;
+						current_index = PageIndex (&everyone, current);
 					}
 				}
 				break;
@@ -179,54 +240,30 @@ int main (int argc, char *argv[]) {
 				About ();
 				break;
 				
-			/* save mosaic */
+			/* save mosaic (in the background: PollFileIO tells how it went) */
 			case KEY_CTRL_S:
-				switch (Save (current)) {
-					case 0:
-						PrintHud (FALSE, "Saved successfully!");
-						break;
-
+				switch (Save (&everyone, current)) {
+					case 0:	// saved, or saving: Save and PollFileIO see to TOUCHED
 					case ERR:	// canceled
 						break;
 
-					default:
-						PrintHud (TRUE, "Sorry, no can save this... =/");
+					case EBUSY:
+						PrintHud (FALSE, "Wait, still busy with the last file...");
 						break;
 				}
-				UN_(TOUCHED);
 				break;
 				
-			/* load mosaic */
+			/* load mosaic (in the background too) */
 			case KEY_CTRL_O:
-				switch (Load (current)) {
-					case 0:
-						PrintHud (FALSE, "Loaded successfully!");
-						ENTER_(TOUCHED | REDRAW);
-						break;
-
-					case ERR:	// canceled
-						break;
-
-					case ENOENT:
-						PrintHud (TRUE, "File doesn't exist");
-						break;
-
-					case ENODIMENSIONS:
-						PrintHud (TRUE, "No dimensions in this file, dude! =/");
-						break;
-
-					case EUNKNSTRGFMT:
-						PrintHud (TRUE, "Sorry, couldn't load attributes...");
-						break;
-
-					default:
-						PrintHud (TRUE, "Sorry, no can load this... =/");
-						break;
+				if (Load (&everyone, &current) == EBUSY) {
+					PrintHud (FALSE, "Wait, still busy with the last file...");
 				}
+				current_index = PageIndex (&everyone, current);
 				break;
 				
 			/* resize mosaic */
 			case KEY_CTRL_R:
+				BeginEdit (current, 0);
 				Resize (current, &cursor);
 				break;
 				
@@ -249,12 +286,20 @@ int main (int argc, char *argv[]) {
 
 			/* Trim MOSAIC */
 			case KEY_CTRL_K:
-				if (AskMessage ("Trim the mosaic?")) {
+				// the canvas' tiles are sparse already
+				if (GetCanvas (current) && !WholeCanvas (current)) {
+					PrintHud (FALSE, "Canvases can't be trimmed");
+				}
+				else if (AskMessage ("Trim the mosaic?")) {
 					int resize = AskMessage ("Resize it?");
+					BeginEdit (current, 0);
+					RecordImage (current);
 					// clear screen, as it may resize
 					ClearWin (current);
 					// Trim and ask if want to resize it
 					TrimCURS_MOS (current, resize);
+					// a duplicated image's tiles take the trimmed view
+					FitCanvas (current);
 					// move to inside the resized MOSAIC
 					MoveResized (&cursor, current);
 					PrintHud (FALSE, "Trimmed");
@@ -286,13 +331,16 @@ int main (int argc, char *argv[]) {
 			case KEY_CTRL_X:
 				UnprintSelection (current);
 				UN_(SELECTION);
+				BeginEdit (current, 0);
 				Cut (&buffer, current, cursor);
+				ENTER_(TOUCHED);
 				break;
 
 			/* paste copy buffer */
 			case KEY_CTRL_V:	
 				UnprintSelection (current);
 				UN_(SELECTION);
+				BeginEdit (current, 0);
 				// if the buffer was never used, sry
 				if (!Paste (&buffer, current, cursor)) {
 					PrintHud (TRUE, "Nothing in the buffer...");
@@ -302,12 +350,45 @@ int main (int argc, char *argv[]) {
 				}
 				break;
 
+			/* paste, fill, recolor or erase in a range of images */
+			case KEY_F(7):
+				if (EditImages (&everyone, current, cursor, &buffer,
+							default_attr) > 0) {
+					ENTER_(TOUCHED);
+				}
+				UnprintSelection (current);
+				UN_(SELECTION);
+				break;
+
 			/* enter moving mode */
 			case KEY_CTRL_N:
 				UnprintSelection (current);
 				UN_(SELECTION);
 				PrintHud (FALSE, "Move selection. ENTER to accept, ESC to cancel");
+				BeginEdit (current, 0);
 				cursor = MoveSelection (current, cursor);
+				ENTER_(TOUCHED);
+				break;
+
+			/* undo/redo */
+			case KEY_CTRL_Z: case KEY_CTRL_Y:
+				{
+					CURS_MOS *aux = c == KEY_CTRL_Z ? Undo () : Redo ();
+					if (!aux) {
+						PrintHud (FALSE, c == KEY_CTRL_Z ?
+								"Nothing to undo" : "Nothing to redo");
+						break;
+					}
+					// show the image that changed
+					if (aux != current) {
+						current = aux;
+						current_index = PageIndex (&everyone, current);
+						VPrintHud (FALSE, "img %d", current_index);
+					}
+					// it may have been resized
+					MoveResized (&cursor, current);
+					ENTER_(TOUCHED);
+				}
 				break;
 
 			/* toggle insert mode */
@@ -318,11 +399,19 @@ int main (int argc, char *argv[]) {
 			/* attribute table */
 			case '\t':
 				default_attr = AttrTable (current, cursor);
+				BeginEdit (current, 0);
 				ChAttrs (current, &cursor, default_attr);
+				ENTER_(TOUCHED);
 				break;
 				
 			/* quit; aww =/ */
 			case KEY_CTRL_Q:
+				// a save may still be going: see how it went before asking
+				if (AsyncRunning ()) {
+					PrintHud (FALSE, "Finishing...");
+					WaitAsync ();
+					PollFileIO (current, &cursor);
+				}
 				// asks if you really want to quit this tottally awesome SW
 				if (IS_(TOUCHED) && !AskQuit ()) {
 					break;
@@ -333,15 +422,18 @@ int main (int argc, char *argv[]) {
 				ungetch (0);
 				break;
 				
-			/* erase entire line/column before cursor
-			 * it actually calls enough times the backspace button */
+			/* erase entire line/column before cursor */
 			case KEY_CTRL_U:
-				EraseLine (current);
+				BeginEdit (current, 0);
+				EraseLine (&cursor, current, REVERSE (default_direction));
+				ENTER_(TOUCHED);
 				break;
 
 			/* erase word (until space is found) */
 			case KEY_CTRL_W:
+				BeginEdit (current, 0);
 				EraseWord (&cursor, current, REVERSE (default_direction));
+				ENTER_(TOUCHED);
 				break;
 			
 			// WARNING: don't change BACKSPACE nor DC out of here nor out of
@@ -363,6 +455,8 @@ int main (int argc, char *argv[]) {
 			/* write at the mosaic, and show it to us */
 			default:
 				if (isprint (c)) {
+					// typing runs are undone at once, but not selection fills
+					BeginEdit (current, !IS_(SELECTION));
 					InsertCh (current, &cursor, c, default_attr, default_direction);
 					ChAttrs (current, &cursor, c != ' ' ? default_attr : Normal);
 					ENTER_(TOUCHED);
@@ -377,19 +471,72 @@ int main (int argc, char *argv[]) {
 				break;
 		}
 		
-		// paint mode: paint it right away!
-		if (IS_(PAINT)) {
+		// duplicated images share their cells while they're not shown: only
+		// the current one's are materialized
+		UnstowCanvas (current);
+		StowCanvases (current);
+
+		// paint mode: paint where the cursor went, or where paint mode was
+		// turned on; not after any key, or an undo would be painted over
+		// (and it's redo lost)
+		const char moved = current == last_current
+				&& (cursor.y != last_cursor.y || cursor.x != last_cursor.x
+					|| cursor.origin_y != last_cursor.origin_y
+					|| cursor.origin_x != last_cursor.origin_x);
+		if (IS_(PAINT) && c != KEY_CTRL_Z && c != KEY_CTRL_Y
+				&& (moved || c == KEY_CTRL_P)) {
+			BeginEdit (current, !IS_(SELECTION));
 			ChAttrs (current, &cursor, default_attr);
 			ENTER_(TOUCHED);
 		}
+
+		// more input for this frame (key-repeat, pasting, slow links):
+		// apply it before drawing anything
+		if ((c = NextFrameKey ()) != ERR) {
+			continue;
+		}
+
+		// then draw it all at once
+		PollFileIO (current, &cursor);
+		if (Autosave (&everyone) > 0) {
+			PrintHud (FALSE, "Couldn't autosave! =/");
+		}
 		DisplayCurrent (current);
-		UpdateHud (cursor, default_direction);
+		// the view reached rows of the file that couldn't be decoded
+		const int corrupted = NewCorruptedRows (current);
+		if (corrupted > 0) {
+			VPrintHud (FALSE, "%d corrupted rows in the file, left blank", corrupted);
+		}
+		UpdateHud (current, cursor, default_direction);
+		EndFrame ();
 		
+		// while loading/saving, wake up now and then to show the progress,
+		// and when it's time to autosave
+		int wait = AutosaveWait ();
+		if (AsyncRunning () && (wait < 0 || wait > ASYNC_POLL_MS)) {
+			wait = ASYNC_POLL_MS;
+		}
+		timeout (wait);
 		c = getch ();
+		timeout (-1);
+	}
+
+	// a save may still be going: it must get to the file
+	if (AsyncRunning ()) {
+		PrintHud (FALSE, "Finishing...");
+		WaitAsync ();
+		PollFileIO (current, &cursor);
 	}
+	// a clean exit: what wasn't saved was given up (AskQuit)
+	EndAutosave ();
 	
 	DestroyCopyBuffer (&buffer);
+	DestroyHistory ();
+	DestroyCanvases ();
+	DestroyJournals ();
 	DestroyIMGS (&everyone);
+	DestroyPages ();
+	DestroyOnion ();
 	DestroyWins ();
 
 	return 0;
@@ -161,20 +161,24 @@ void InitMenus () {
 	x_aux += MENU_X_SEPARATOR;
 	image_menuWindow = CreateBoxedTitledWindow (MENU_HEIGHT, MENU_WIDTH, LINES - MENU_HEIGHT - 2, x_aux, "IMAGE");
 	
-	num_items = 5;
+	num_items = 7;
 	const char *image_titles[] = {
 		"New Image",
 		"Save Image",
 		"Load Image",
 		"Resize Image",
-		"Trim Image"
+		"Trim Image",
+		"Play Images",
+		"Onion Skin"
 	};
 	const char *image_descriptions[] = {
 		"F2",
 		"^S",
 		"^O",
 		"^R",
-		"^K"
+		"^K",
+		"F5",
+		"F6"
 	};
 	// The choices are static so that the userptr points to something that exists
 	static const int image_choices[] = {
@@ -182,7 +186,9 @@ void InitMenus () {
 		KEY_CTRL_S,
 		KEY_CTRL_O,
 		KEY_CTRL_R,
-		KEY_CTRL_K
+		KEY_CTRL_K,
+		KEY_F(5),
+		KEY_F(6)
 	};
 	// create the items
 	items = (ITEM **) malloc ((num_items + 1) * sizeof (ITEM *));
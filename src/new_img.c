@@ -19,24 +19,24 @@ void InitNewMOSAIC (int initial_height, int initial_width) {
 	/* MAKING OF FORM */
 	FIELD **fields = (FIELD **) malloc (5 * sizeof (FIELD *));
 
-	fields[0] = new_field (1, 3, 0, 0, 0, 0);
+	fields[0] = new_field (1, 5, 0, 0, 0, 0);
 	set_field_back (fields[0], A_BOLD);
 	field_opts_off (fields[0], O_PASSOK);
 	set_field_just (fields[0], JUSTIFY_LEFT);
-	set_field_type (fields[0], TYPE_INTEGER, 0, 1, 999);
+	set_field_type (fields[0], TYPE_INTEGER, 0, 1, MAX_CANVAS_SIDE);
 	// initial_height as a string, to start the buffer
-	char height[4];
-	sprintf (height, "%3d", initial_height);
+	char height[6];
+	sprintf (height, "%5d", initial_height);
 	set_field_buffer (fields[0], 0, height);
 
-	fields[1] = new_field (1, 3, 1, 0, 0, 0);
+	fields[1] = new_field (1, 5, 1, 0, 0, 0);
 	set_field_back (fields[1], A_BOLD);
 	field_opts_off (fields[1], O_PASSOK);
 	set_field_just (fields[1], JUSTIFY_LEFT);
-	set_field_type (fields[1], TYPE_INTEGER, 0, 1, 999);
+	set_field_type (fields[1], TYPE_INTEGER, 0, 1, MAX_CANVAS_SIDE);
 	// initial_width as a string, to start the buffer
-	char width[4];
-	sprintf (width, "%3d", initial_width);
+	char width[6];
+	sprintf (width, "%5d", initial_width);
 	set_field_buffer (fields[1], 0, width);
 
 	fields[2] = new_field (1, 3, 2, 0, 0, 0);
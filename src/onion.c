@@ -0,0 +1,228 @@
+#include "onion.h"
+#include "maae.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/// What shows through the blank cells of the image with the onion skin
+static struct {
+	CURS_MOS *img;	///< the image it's for; NULL if none
+	CURS_MOS *under[2];	///< the images under it, previous first
+	int height, width;	///< img's dimensions
+	int under_height[2], under_width[2];	///< under's dimensions
+	int y, x;	///< img's view position, if it's a canvas
+	chtype *cells;	///< height * width cells, 0 where nothing shows
+	char stale;	///< is there a part to be composed again?
+	Rect stale_rect;	///< that part, in img's coordinates
+} onion;
+
+
+/// Aux function: where img's view is, if it's a canvas
+static void ViewOrigin (CURS_MOS *img, int *y, int *x) {
+	Canvas *canvas = GetCanvas (img);
+	*y = canvas ? canvas->y : 0;
+	*x = canvas ? canvas->x : 0;
+}
+
+
+/// Aux function: does the cache still fit current and it's neighbours?
+static int Fits (CURS_MOS *current) {
+	int y, x, i;
+	ViewOrigin (current, &y, &x);
+	if (onion.img != current || onion.under[0] != current->prev
+			|| onion.under[1] != current->next
+			|| onion.height != current->img->height
+			|| onion.width != current->img->width
+			|| onion.y != y || onion.x != x) {
+		return 0;
+	}
+	for (i = 0; i < 2; i++) {
+		if (onion.under_height[i] != onion.under[i]->img->height
+				|| onion.under_width[i] != onion.under[i]->img->width) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+
+/**
+ * Aux function: reads into cells what img has at y/x, in canvas coordinates
+ * for canvases; outside img, cells are blank
+ */
+static void ReadUnder (CURS_MOS *img, MOSAIC *cells, int y, int x) {
+	Canvas *canvas = GetCanvas (img);
+	if (canvas) {
+		ReadCanvasCells (canvas, cells, y, x);
+		return;
+	}
+
+	FillRect (cells, 0, 0, cells->height - 1, cells->width - 1, ' ', Normal,
+			FILL_CH | FILL_ATTR);
+	const int from = max (x, 0);
+	const int to = min (x + cells->width, img->img->width);
+	int i;
+	for (i = max (y, 0); i < y + cells->height && i < img->img->height; i++) {
+		if (from < to) {
+			memcpy (cells->mosaic + MOS_INDEX (cells, i - y, from - x),
+					img->img->mosaic + MOS_INDEX (img->img, i, from),
+					(to - from) * sizeof (mos_char));
+			memcpy (cells->attr + MOS_INDEX (cells, i - y, from - x),
+					img->img->attr + MOS_INDEX (img->img, i, from),
+					(to - from) * sizeof (mos_attr));
+		}
+	}
+}
+
+
+/// Aux function: composes again the cached cells in r
+static void Compose (Rect r) {
+	const int height = r.BRy - r.ULy + 1, width = r.BRx - r.ULx + 1;
+	int i, y, x;
+	for (y = r.ULy; y <= r.BRy; y++) {
+		for (x = r.ULx; x <= r.BRx; x++) {
+			onion.cells[y * onion.width + x] = 0;
+		}
+	}
+
+	MOSAIC *cells = NewMOSAIC (height, width);
+	// the next one first, so the previous is over it
+	for (i = 1; i >= 0; i--) {
+		CURS_MOS *under = onion.under[i];
+		if (under == onion.img || (i == 1 && under == onion.under[0])) {
+			continue;
+		}
+		ReadUnder (under, cells, onion.y + r.ULy, onion.x + r.ULx);
+		for (y = 0; y < height; y++) {
+			for (x = 0; x < width; x++) {
+				const int k = MOS_INDEX (cells, y, x);
+				if (cells->mosaic[k] != ' ' || cells->attr[k] != Normal) {
+					onion.cells[(y + r.ULy) * onion.width + x + r.ULx] =
+							(unsigned char) cells->mosaic[k]
+							| CursesAttr (cells->attr[k]) | A_DIM;
+				}
+			}
+		}
+	}
+	FreeMOSAIC (cells);
+}
+
+
+/// Aux function: forgets the cache, rewriting it's image's pad without it
+static void Drop () {
+	CURS_MOS *img = onion.img;
+	onion.img = NULL;
+	onion.stale = 0;
+	if (img) {
+		RewriteRect (img, 0, 0, img->img->height - 1, img->img->width - 1);
+	}
+}
+
+
+/// Aux function: builds the cache for current, from scratch
+static void Build (CURS_MOS *current) {
+	int i;
+	onion.img = current;
+	onion.under[0] = current->prev;
+	onion.under[1] = current->next;
+	onion.height = current->img->height;
+	onion.width = current->img->width;
+	for (i = 0; i < 2; i++) {
+		onion.under_height[i] = onion.under[i]->img->height;
+		onion.under_width[i] = onion.under[i]->img->width;
+	}
+	ViewOrigin (current, &onion.y, &onion.x);
+	const int n = max (onion.height * onion.width, 1);
+	free (onion.cells);
+	onion.cells = (chtype *) malloc ((size_t) n * sizeof (chtype));
+	onion.stale = 0;
+
+	if (onion.height > 0 && onion.width > 0) {
+		Rect all = {0, 0, onion.height - 1, onion.width - 1};
+		Compose (all);
+	}
+}
+
+
+const chtype *OnionRow (CURS_MOS *img, int y) {
+	if (img != onion.img || y < 0 || y >= onion.height) {
+		return NULL;
+	}
+	return onion.cells + (size_t) y * onion.width;
+}
+
+
+void OnionDirty (CURS_MOS *img, int ULy, int ULx, int BRy, int BRx) {
+	if (!onion.img || img == onion.img
+			|| (img != onion.under[0] && img != onion.under[1])) {
+		return;
+	}
+
+	Rect r = {0, 0, onion.height - 1, onion.width - 1};
+	// a canvas' view coordinates aren't the image's: compose it all again
+	if (!GetCanvas (img)) {
+		r.ULy = max (ULy - onion.y, 0);
+		r.ULx = max (ULx - onion.x, 0);
+		r.BRy = min (BRy - onion.y, onion.height - 1);
+		r.BRx = min (BRx - onion.x, onion.width - 1);
+	}
+	if (r.ULy > r.BRy || r.ULx > r.BRx) {
+		return;
+	}
+
+	if (onion.stale) {
+		r.ULy = min (r.ULy, onion.stale_rect.ULy);
+		r.ULx = min (r.ULx, onion.stale_rect.ULx);
+		r.BRy = max (r.BRy, onion.stale_rect.BRy);
+		r.BRx = max (r.BRx, onion.stale_rect.BRx);
+	}
+	onion.stale_rect = r;
+	onion.stale = 1;
+}
+
+
+int UpdateOnion (CURS_MOS *current) {
+	if (!IS_(ONION)) {
+		Drop ();
+		return 0;
+	}
+	if (!Fits (current)) {
+		if (onion.img != current) {
+			Drop ();
+		}
+		Build (current);
+		return 1;
+	}
+	if (onion.stale) {
+		onion.stale = 0;
+		Compose (onion.stale_rect);
+		MarkDirty (current, onion.stale_rect.ULy, onion.stale_rect.ULx,
+				onion.stale_rect.BRy, onion.stale_rect.BRx);
+	}
+	return 0;
+}
+
+
+void OverlayOnion (CURS_MOS *current) {
+	int y, x;
+	for (y = 0; y < current->img->height; y++) {
+		const chtype *under = OnionRow (current, y);
+		if (!under) {
+			return;
+		}
+		for (x = 0; x < current->img->width; x++) {
+			const int k = MOS_INDEX (current->img, y, x);
+			if (under[x] && current->img->mosaic[k] == ' '
+					&& current->img->attr[k] == Normal) {
+				mvwaddch (current->win, y, x, under[x]);
+			}
+		}
+	}
+}
+
+
+void DestroyOnion () {
+	free (onion.cells);
+	onion.cells = NULL;
+	onion.img = NULL;
+}
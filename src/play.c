@@ -0,0 +1,129 @@
+#include "play.h"
+#include "maae.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+/// Time between frames, in nanoseconds
+static long long frame_interval = 1000000000LL / DEFAULT_PLAY_FPS;
+
+
+void SetPlayRate (int fps) {
+	fps = max (fps, 1);
+	frame_interval = 1000000000LL / fps;
+}
+
+
+/// Aux function: nanoseconds since start
+static long long Since (struct timespec start) {
+	struct timespec now;
+	clock_gettime (CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start.tv_sec) * 1000000000LL
+			+ (now.tv_nsec - start.tv_nsec);
+}
+
+
+/**
+ * Aux function: writes in win the cells of frame that differ from what
+ * it shows, as kept in shown
+ *
+ * @param[in] cells Win-sized, to read whole canvases (WholeCanvas) in, as
+ * their views may be stowed
+ *
+ * @return How many cells were written
+ */
+static int DrawFrame (WINDOW *win, chtype *shown, CURS_MOS *frame,
+		MOSAIC *cells) {
+	MOSAIC *img = frame->img;
+	int top = frame->y, left = frame->x;
+	int bottom = img->height, right = img->width;
+	if (WholeCanvas (frame)) {
+		Canvas *canvas = GetCanvas (frame);
+		ReadCanvasCells (canvas, cells, top, left);
+		img = cells;
+		bottom = canvas->tiles->height - top;
+		right = canvas->tiles->width - left;
+		top = left = 0;
+	}
+	int height, width;
+	getmaxyx (win, height, width);
+	int written = 0;
+	int y, x;
+	for (y = 0; y < height; y++) {
+		const int img_y = y + top;
+		for (x = 0; x < width; x++) {
+			const int img_x = x + left;
+			// past the image's borders, there's nothing
+			chtype ch = ' ';
+			if (img_y < bottom && img_x < right) {
+				const int k = MOS_INDEX (img, img_y, img_x);
+				ch = (unsigned char) img->mosaic[k] | CursesAttr (img->attr[k]);
+			}
+			if (shown[y * width + x] != ch) {
+				mvwaddch (win, y, x, ch);
+				shown[y * width + x] = ch;
+				written++;
+			}
+		}
+	}
+	return written;
+}
+
+
+CURS_MOS *Play (IMGS *everyone, CURS_MOS *current, PlayStats *stats) {
+	const int height = MOSAIC_PAD_HEIGHT, width = MOSAIC_PAD_WIDTH;
+	WINDOW *win = newwin (height, width, 0, 0);
+	// nothing is known about what's there: the first frame writes it all
+	chtype *shown = (chtype *) malloc ((size_t) height * width * sizeof (chtype));
+	int i;
+	for (i = 0; i < height * width; i++) {
+		shown[i] = (chtype) -1;
+	}
+	MOSAIC *cells = NewMOSAIC (height, width);
+
+	stats->shown = stats->dropped = 0;
+	stats->cells = 0;
+	const int first = PageIndex (everyone, current);
+	CURS_MOS *frame = current;
+	struct timespec start;
+	clock_gettime (CLOCK_MONOTONIC, &start);
+	long long k, last = -1, hud_second = -1;
+	for (k = 0; ; ) {
+		// late for some: skip them, so the animation keeps it's pace
+		stats->dropped += k - last - 1;
+		const int index = (first + k) % everyone->size;
+		frame = GoToPage (everyone, index);
+		stats->cells += DrawFrame (win, shown, frame, cells);
+		stats->shown++;
+		wnoutrefresh (win);
+		doupdate ();
+		last = k;
+		// once a second is enough for the HUD
+		const long long second = Since (start) / 1000000000LL;
+		if (second != hud_second) {
+			VPrintHud (FALSE, "Playing img %d, %d dropped (any key stops)",
+					index, stats->dropped);
+			hud_second = second;
+		}
+
+		// wait for the next frame's time, or a key
+		const long long wait = (last + 1) * frame_interval - Since (start);
+		timeout (wait > 0 ? (wait + 999999) / 1000000 : 0);
+		const int c = getch ();
+		timeout (-1);
+		if (c != ERR) {
+			break;
+		}
+		const long long due = Since (start) / frame_interval;
+		k = max (due, last + 1);
+	}
+
+	// blank, so whatever the pad doesn't cover isn't left with the frame
+	werase (win);
+	wnoutrefresh (win);
+	delwin (win);
+	free (shown);
+	FreeMOSAIC (cells);
+
+	return frame;
+}
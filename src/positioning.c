@@ -1,51 +1,156 @@
 #include "positioning.h"
 #include "wins.h"
+#include "cells.h"
+#include "canvas.h"
 
 void InitCursor (Cursor *cur) {
 	cur->x = cur->y = cur->origin_x = cur->origin_y = 0;
 }
 
 
+/// The scrolling margin
+static int scroll_margin = DEFAULT_SCROLL_MARGIN;
+
+
 void DisplayCurrentMOSAIC (CURS_MOS *current) {
 	show_panel (current->pan);
 	update_panels ();
-	doupdate ();
-	prefresh (current->win,
-			current->y * MOSAIC_PAD_HEIGHT, current->x * MOSAIC_PAD_WIDTH,
+	pnoutrefresh (current->win, current->y, current->x,
 			0, 0, MOSAIC_PAD_HEIGHT - 1, MOSAIC_PAD_WIDTH - 1);
 }
 
 
+/**
+ * The selection box currently printed in a pad
+ *
+ * We keep track of it so that moving the selection only touches the cells
+ * that entered or left the box, instead of rewriting the whole pad
+ */
+static struct {
+	CURS_MOS *owner;	///< the CURS_MOS it's printed in; NULL if none
+	int ULy, ULx, BRy, BRx;	///< the printed box corners
+} printed_box;
+
+
+/// Aux function: reverse the [from, to] span in a row, if it's not empty
+static void ReverseSpan (CURS_MOS *current, int y, int from, int to) {
+	if (from <= to) {
+		mvwchgat (current->win, y, from, to - from + 1, A_REVERSE, Normal, NULL);
+	}
+}
+
+
 void PrintSelection (Cursor *position, CURS_MOS *current) {
 	int ULy = min (position->origin_y, position->y);
 	int ULx = min (position->origin_x, position->x);
 	int BRy = max (position->origin_y, position->y);
 	int BRx = max (position->origin_x, position->x);
 
-	// undo
-	UnprintSelection (current);
+	// printed somewhere else: undo it all there
+	if (printed_box.owner != current) {
+		UnprintSelection (current);
+	}
+
+	// old box's rows, or an empty range if there's no old box
+	int oldULy = printed_box.owner ? printed_box.ULy : 1;
+	int oldBRy = printed_box.owner ? printed_box.BRy : 0;
+
+	int y;
+	const int top = printed_box.owner ? min (oldULy, ULy) : ULy;
+	const int bottom = printed_box.owner ? max (oldBRy, BRy) : BRy;
+	for (y = top; y <= bottom; y++) {
+		// spans in this row; [1, 0] is the empty one
+		int old_from = 1, old_to = 0, new_from = 1, new_to = 0;
+		if (y >= oldULy && y <= oldBRy) {
+			old_from = printed_box.ULx;
+			old_to = printed_box.BRx;
+		}
+		if (y >= ULy && y <= BRy) {
+			new_from = ULx;
+			new_to = BRx;
+		}
 
-	// redo
-	int i;
-	for (i = ULy; i <= BRy; i++) {
-		mvwchgat (current->win, i, ULx, BRx - ULx + 1, A_REVERSE, Normal, NULL);
+		// what left the box goes back to normal...
+		RewriteSpan (current, y, old_from, min (old_to, new_from - 1));
+		RewriteSpan (current, y, max (old_from, new_to + 1), old_to);
+		// ...and what entered it gets reversed
+		ReverseSpan (current, y, new_from, min (new_to, old_from - 1));
+		ReverseSpan (current, y, max (new_from, old_to + 1), new_to);
 	}
 
+	printed_box.owner = current;
+	printed_box.ULy = ULy;
+	printed_box.ULx = ULx;
+	printed_box.BRy = BRy;
+	printed_box.BRx = BRx;
+
 	DisplayCurrentMOSAIC (current);
 }
 
 
+void ReprintSelection (CURS_MOS *current) {
+	if (printed_box.owner == current) {
+		int y;
+		for (y = printed_box.ULy; y <= printed_box.BRy; y++) {
+			ReverseSpan (current, y, printed_box.ULx, printed_box.BRx);
+		}
+	}
+}
+
+
 void UnprintSelection (CURS_MOS *current) {
-	RewriteCURS_MOS (current);
+	// the box may be printed in another image, so use its owner
+	if (printed_box.owner) {
+		RewriteRect (printed_box.owner, printed_box.ULy, printed_box.ULx,
+				printed_box.BRy, printed_box.BRx);
+		printed_box.owner = NULL;
+	}
+}
+
+
+void SetScrollMargin (int margin) {
+	scroll_margin = max (margin, 0);
+}
+
+
+int FollowPosition (int start, int view, int length, int pos) {
+	// a margin over half the view would never let the cursor rest
+	const int margin = min (scroll_margin, (view - 1) / 2);
+
+	if (pos < start + margin) {
+		start = pos - margin;
+	}
+	else if (pos > start + view - 1 - margin) {
+		start = pos - view + 1 + margin;
+	}
+	start = min (start, length - view);
+	start = max (start, 0);
+
+	return start;
 }
 
 
 void MoveTo (Cursor *position, CURS_MOS *current, int y, int x) {
-	// make sure y and x are within 'current'
-	y = max (y, 0);
-	x = max (x, 0);
-	y = min (y, current->img->height - 1);
-	x = min (x, current->img->width - 1);
+	// make sure y and x are within 'current' (canvases go beyond the view)
+	Rect bounds;
+	CanvasBounds (current, &bounds);
+	y = max (y, bounds.ULy);
+	x = max (x, bounds.ULx);
+	y = min (y, bounds.BRy);
+	x = min (x, bounds.BRx);
+
+	// canvases move their view along; the selection's origin stays where
+	// it was in the canvas, as long as it's in the view
+	if (FollowCanvas (current, &y, &x)) {
+		Rect moved;
+		CanvasBounds (current, &moved);
+		position->origin_y += moved.ULy - bounds.ULy;
+		position->origin_x += moved.ULx - bounds.ULx;
+		position->origin_y = max (position->origin_y, 0);
+		position->origin_x = max (position->origin_x, 0);
+		position->origin_y = min (position->origin_y, current->img->height - 1);
+		position->origin_x = min (position->origin_x, current->img->width - 1);
+	}
 
 	// change the position
 	position->y = y;
@@ -63,15 +168,16 @@ void MoveTo (Cursor *position, CURS_MOS *current, int y, int x) {
 	int old_curs_mos_y = current->y;
 	int old_curs_mos_x = current->x;
 	
-	// update
-	current->y = y / MOSAIC_PAD_HEIGHT;
-	current->x = x / MOSAIC_PAD_WIDTH;
-
-	// if we changed block, reprint it all
+	// scroll, keeping the margin
+	current->y = FollowPosition (current->y, MOSAIC_PAD_HEIGHT,
+			current->img->height, y);
+	current->x = FollowPosition (current->x, MOSAIC_PAD_WIDTH,
+			current->img->width, x);
+
+	// if we scrolled, the pad must be copied again. The border didn't move,
+	// as the view never goes past the image
 	if (current->y != old_curs_mos_y || current->x != old_curs_mos_x) {
-		erase ();
-		ReHud ();
-		ENTER_(REDRAW);
+		ENTER_(REBORDER);
 	}
 }
 
@@ -101,22 +207,24 @@ void Move (Cursor *position, CURS_MOS *current, Direction dir) {
 
 
 void MoveAll (Cursor *position, CURS_MOS *current, Direction dir) {
+	Rect bounds;
+	CanvasBounds (current, &bounds);
 	// change the cursor position, depending on the direction
 	switch (dir) {
 		case UP:
-			position->y = 0;
+			position->y = bounds.ULy;
 			break;
 		
 		case DOWN:
-			position->y = current->img->height - 1;
+			position->y = bounds.BRy;
 			break;
 			
 		case LEFT:
-			position->x = 0;
+			position->x = bounds.ULx;
 			break;
 			
 		case RIGHT:
-			position->x = current->img->width - 1;
+			position->x = bounds.BRx;
 			break;
 	}
 
@@ -130,18 +238,63 @@ void MoveResized (Cursor *position, CURS_MOS *current) {
 }
 
 
-CURS_MOS * GoToPage (IMGS *everyone, unsigned int index) {
-	if (index < everyone->size) {
-		CURS_MOS *aux;
-		for (aux = everyone->list; index; index--) {
-			aux = aux->next;
-		}
+/// The images in the order they're in the IMGS, from it's list on
+static struct {
+	CURS_MOS **imgs;	///< the table
+	int size;	///< how many fit in it
+} pages = {NULL, 0};
+
 
-		return aux;
+void AddPage (IMGS *everyone, CURS_MOS *current, CURS_MOS *img,
+		enum direction dir) {
+	int index;
+	// first image: no one's after or before
+	if (everyone->list == NULL) {
+		CircularIMGS (everyone, img);
+		index = 0;
 	}
 	else {
-		return NULL;
+		LinkCURS_MOS (current, img, dir);
+		index = PageIndex (everyone, current) + (dir == after);
+		// before the list's first is after it's last, as the list goes round
+		if (index == 0) {
+			index = everyone->size;
+		}
 	}
+
+	if (everyone->size == pages.size) {
+		pages.size = pages.size ? 2 * pages.size : 16;
+		pages.imgs = (CURS_MOS **) realloc (pages.imgs,
+				pages.size * sizeof (CURS_MOS *));
+	}
+	memmove (pages.imgs + index + 1, pages.imgs + index,
+			(everyone->size - index) * sizeof (CURS_MOS *));
+	pages.imgs[index] = img;
+	everyone->size++;
+}
+
+
+CURS_MOS * GoToPage (IMGS *everyone, unsigned int index) {
+	return index < everyone->size ? pages.imgs[index] : NULL;
+}
+
+
+int PageIndex (IMGS *everyone, CURS_MOS *img) {
+	int index;
+	for (index = 0; index < everyone->size; index++) {
+		if (pages.imgs[index] == img) {
+			return index;
+		}
+	}
+
+	return -1;
+}
+
+
+void DestroyPages () {
+	free (pages.imgs);
+	pages.imgs = NULL;
+	pages.size = 0;
 }
 
 
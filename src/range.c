@@ -0,0 +1,189 @@
+#include "range.h"
+#include "maae.h"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+/// The images being edited, shared by the workers
+static struct {
+	CURS_MOS **imgs;	///< the images
+	int size;	///< how many there are
+	int next;	///< next image to be taken by a worker
+	const RangeEdit *edit;	///< what's done in them
+	pthread_mutex_t lock;	///< protects next
+} range;
+
+
+/// Aux function: the cells edit changes, before clipping
+static Rect Area (const RangeEdit *edit) {
+	Rect area = edit->rect;
+	if (edit->op == RANGE_PASTE) {
+		area.BRy = area.ULy + edit->src.height - 1;
+		area.BRx = area.ULx + edit->src.width - 1;
+	}
+	return area;
+}
+
+
+/// Aux function: does the edit in img, whose upper-left corner is at y/x
+static void Apply (MOSAIC *img, const RangeEdit *edit, int y, int x) {
+	Rect r = edit->rect;
+	r.ULy -= y;
+	r.ULx -= x;
+	r.BRy -= y;
+	r.BRx -= x;
+	switch (edit->op) {
+		case RANGE_PASTE:
+			Blit (img, r.ULy, r.ULx, edit->src, edit->key);
+			break;
+
+		case RANGE_FILL:
+			FillRect (img, r.ULy, r.ULx, r.BRy, r.BRx, edit->ch, edit->attr,
+					FILL_CH | FILL_ATTR);
+			break;
+
+		case RANGE_RECOLOR:
+			FillRect (img, r.ULy, r.ULx, r.BRy, r.BRx, ' ', edit->attr,
+					FILL_ATTR);
+			break;
+
+		case RANGE_ERASE:
+			FillRect (img, r.ULy, r.ULx, r.BRy, r.BRx, ' ', Normal,
+					FILL_CH | FILL_ATTR);
+			break;
+	}
+}
+
+
+/// Aux function: does the edit in a stowed canvas, in it's tiles, so it's
+/// view isn't materialized for it
+static void ApplyStowed (CURS_MOS *img, const RangeEdit *edit, Rect area) {
+	Rect bounds;
+	CanvasBounds (img, &bounds);
+	area.ULy = max (area.ULy, 0);
+	area.ULx = max (area.ULx, 0);
+	area.BRy = min (area.BRy, bounds.BRy);
+	area.BRx = min (area.BRx, bounds.BRx);
+	if (area.ULy > area.BRy || area.ULx > area.BRx) {
+		return;
+	}
+	MOSAIC *cells = NewMOSAIC (area.BRy - area.ULy + 1, area.BRx - area.ULx + 1);
+	ReadCanvasCells (GetCanvas (img), cells, area.ULy, area.ULx);
+	Apply (cells, edit, area.ULy, area.ULx);
+	WriteCanvasCells (GetCanvas (img), cells, area.ULy, area.ULx);
+	FreeMOSAIC (cells);
+}
+
+
+/// Aux function: a worker takes the next image until there's none
+static void *Worker (void *arg) {
+	while (1) {
+		pthread_mutex_lock (&range.lock);
+		const int i = range.next++;
+		pthread_mutex_unlock (&range.lock);
+
+		if (i >= range.size) {
+			return NULL;
+		}
+		Apply (range.imgs[i]->img, range.edit, 0, 0);
+	}
+}
+
+
+int EditRange (IMGS *everyone, CURS_MOS *current, int first, int last,
+		const RangeEdit *edit, int jobs, int *skipped) {
+	*skipped = 0;
+	if (first < 0 || first >= everyone->size) {
+		return ERR;
+	}
+	last = min (last, everyone->size - 1);
+	last = max (last, first);
+
+	// the current one first, so undoing them gets back to it
+	range.imgs = (CURS_MOS **) malloc ((last - first + 1) * sizeof (CURS_MOS *));
+	range.size = 0;
+	const int current_index = PageIndex (everyone, current);
+	if (first <= current_index && current_index <= last
+			&& (!GetCanvas (current) || WholeCanvas (current))) {
+		range.imgs[range.size++] = current;
+	}
+	int i;
+	for (i = first; i <= last; i++) {
+		CURS_MOS *img = GoToPage (everyone, i);
+		if (GetCanvas (img) && !WholeCanvas (img)) {
+			(*skipped)++;
+		}
+		else if (img != current) {
+			range.imgs[range.size++] = img;
+		}
+	}
+
+	// recording isn't thread safe: it's all done before
+	const Rect area = Area (edit);
+	long cells = 0;
+	JoinEdits (1);
+	for (i = 0; i < range.size; i++) {
+		BeginEdit (range.imgs[i], 0);
+		RecordRect (range.imgs[i], area.ULy, area.ULx, area.BRy, area.BRx);
+	}
+	JoinEdits (0);
+
+	// stowed whole canvases are edited in their tiles, that they may
+	// share: not by the workers, that get only the views
+	int stowed = 0;
+	for (i = 0; i < range.size; i++) {
+		CURS_MOS *img = range.imgs[i];
+		if (StowedCanvas (img)) {
+			ApplyStowed (img, edit, area);
+			OnionDirty (img, area.ULy, area.ULx, area.BRy, area.BRx);
+			stowed++;
+		}
+		else {
+			range.imgs[i - stowed] = img;
+			cells += (long) (area.BRy - area.ULy + 1) * (area.BRx - area.ULx + 1);
+		}
+	}
+	const int edited = range.size;
+	range.size -= stowed;
+
+	// the pool: no more workers than images, nor than the cells are worth
+	if (jobs <= 0) {
+		jobs = sysconf (_SC_NPROCESSORS_ONLN);
+	}
+	const int worth = cells / RANGE_CELLS_PER_JOB + 1;
+	jobs = min (jobs, worth);
+	jobs = min (jobs, range.size);
+	jobs = max (jobs, 1);
+	range.edit = edit;
+	range.next = 0;
+	pthread_mutex_init (&range.lock, NULL);
+	pthread_t *workers = (pthread_t *) malloc ((jobs - 1) * sizeof (pthread_t));
+	for (i = 0; i < jobs - 1; i++) {
+		pthread_create (&workers[i], NULL, Worker, NULL);
+	}
+	// and we're a worker too
+	Worker (NULL);
+	for (i = 0; i < jobs - 1; i++) {
+		pthread_join (workers[i], NULL);
+	}
+	free (workers);
+	pthread_mutex_destroy (&range.lock);
+
+	// only the current one is drawn; the others' pads are just kept
+	// up to date, for when they're shown
+	for (i = 0; i < range.size; i++) {
+		CURS_MOS *img = range.imgs[i];
+		if (img == current) {
+			MarkDirty (img, area.ULy, area.ULx, area.BRy, area.BRx);
+		}
+		else {
+			RewriteRect (img, area.ULy, area.ULx, area.BRy, area.BRx);
+			OnionDirty (img, area.ULy, area.ULx, area.BRy, area.BRx);
+		}
+	}
+
+	free (range.imgs);
+	range.imgs = NULL;
+	return edited;
+}
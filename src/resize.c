@@ -4,7 +4,7 @@ WINDOW *resizeWindow;
 PANEL *resizePanel;
 
 #define RESIZE_height 4
-#define RESIZE_width 17
+#define RESIZE_width 19
 
 void InitResizeMOSAIC () {
 	resizeWindow = CreateCenteredBoxedTitledWindow (RESIZE_height,
@@ -16,24 +16,24 @@ void InitResizeMOSAIC () {
 
 	/* MAKING OF FORM */
 	FIELD **fields = (FIELD **) malloc (3 * sizeof (FIELD *));
-	fields[0] = new_field (1, 3, 0, 0, 0, 0);
+	fields[0] = new_field (1, 5, 0, 0, 0, 0);
 	set_field_back (fields[0], A_BOLD);
 	field_opts_off (fields[0], O_PASSOK);
 	set_field_just (fields[0], JUSTIFY_LEFT);
-	set_field_type (fields[0], TYPE_INTEGER, 0, 1, 999);
+	set_field_type (fields[0], TYPE_INTEGER, 0, 1, MAX_CANVAS_SIDE);
 
-	fields[1] = new_field (1, 3, 1, 0, 0, 0);
+	fields[1] = new_field (1, 5, 1, 0, 0, 0);
 	set_field_back (fields[1], A_BOLD);
 	field_opts_off (fields[1], O_PASSOK);
 	set_field_just (fields[1], JUSTIFY_LEFT);
-	set_field_type (fields[1], TYPE_INTEGER, 0, 1, 999);
+	set_field_type (fields[1], TYPE_INTEGER, 0, 1, MAX_CANVAS_SIDE);
 
 	fields[2] = NULL;
 
 	// the FORM itself, WINDOW and post it!
 	resize_form = new_form (fields);
 	// subwindow: inside the box
-	WINDOW *subwindow = derwin (resizeWindow, 2, 3, 1, 12);
+	WINDOW *subwindow = derwin (resizeWindow, 2, 5, 1, 12);
 	set_form_win (resize_form, subwindow);
 	set_form_sub (resize_form, subwindow);
 	post_form (resize_form);
@@ -49,12 +49,12 @@ char AskResizeMOSAIC (int *new_height, int *new_width) {
 	}
 
 	// current height, to start the buffer
-	char height[4];
-	sprintf (height, "%3d", *new_height);
+	char height[6];
+	sprintf (height, "%5d", *new_height);
 	set_field_buffer (form_fields (resize_form)[0], 0, height);
 	// current width, to start the buffer
-	char width[4];
-	sprintf (width, "%3d", *new_width);
+	char width[6];
+	sprintf (width, "%5d", *new_width);
 	set_field_buffer (form_fields (resize_form)[1], 0, width);
 
 	// display the panel
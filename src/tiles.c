@@ -0,0 +1,327 @@
+#include "tiles.h"
+#include "cells.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/// Initial hash table size; it doubles as tiles come
+#define INITIAL_BUCKETS 64
+
+
+/// Aux function: the hash bucket for tile ty/tx
+static int Bucket (TileMap *map, int ty, int tx) {
+	unsigned int h = (unsigned int) ty * 73856093u ^ (unsigned int) tx * 19349663u;
+	return h % map->n_buckets;
+}
+
+
+/// Aux function: is the cell blank (nothing to store)?
+#define IS_BLANK(c, a) ((c) == ' ' && (a) == Normal)
+
+
+/// Aux function: lets go of a tile's cells, freeing them if no one else
+/// has them
+static void ReleaseCells (TileCells *cells) {
+	if (--cells->refs == 0) {
+		free (cells);
+	}
+}
+
+
+TileMap *NewTileMap (int height, int width) {
+	TileMap *map = (TileMap *) malloc (sizeof (TileMap));
+	map->height = height;
+	map->width = width;
+	map->n_buckets = INITIAL_BUCKETS;
+	map->buckets = (Tile **) calloc (map->n_buckets, sizeof (Tile *));
+	map->n_tiles = 0;
+
+	return map;
+}
+
+
+void FreeTileMap (TileMap *map) {
+	if (map) {
+		int i;
+		Tile *tile, *aux;
+		for (i = 0; i < map->n_buckets; i++) {
+			for (tile = map->buckets[i]; tile; tile = aux) {
+				aux = tile->next;
+				ReleaseCells (tile->cells);
+				free (tile);
+			}
+		}
+		free (map->buckets);
+		free (map);
+	}
+}
+
+
+/// Aux function: doubles the hash table, rehashing everyone
+static void Grow (TileMap *map) {
+	Tile **old = map->buckets;
+	int i, old_n = map->n_buckets;
+
+	map->n_buckets *= 2;
+	map->buckets = (Tile **) calloc (map->n_buckets, sizeof (Tile *));
+	for (i = 0; i < old_n; i++) {
+		Tile *tile, *aux;
+		for (tile = old[i]; tile; tile = aux) {
+			aux = tile->next;
+			int b = Bucket (map, tile->ty, tile->tx);
+			tile->next = map->buckets[b];
+			map->buckets[b] = tile;
+		}
+	}
+	free (old);
+}
+
+
+/// Aux function: a new tile in the table, with the cells given
+static Tile *AddTile (TileMap *map, int ty, int tx, TileCells *cells) {
+	if (map->n_tiles >= map->n_buckets * 2) {
+		Grow (map);
+	}
+
+	Tile *tile = (Tile *) malloc (sizeof (Tile));
+	tile->ty = ty;
+	tile->tx = tx;
+	tile->cells = cells;
+
+	int b = Bucket (map, ty, tx);
+	tile->next = map->buckets[b];
+	map->buckets[b] = tile;
+	map->n_tiles++;
+
+	return tile;
+}
+
+
+/// Aux function: takes a tile off the table and frees it
+static void RemoveTile (TileMap *map, Tile *tile) {
+	Tile **link = &map->buckets[Bucket (map, tile->ty, tile->tx)];
+	while (*link != tile) {
+		link = &(*link)->next;
+	}
+	*link = tile->next;
+	ReleaseCells (tile->cells);
+	free (tile);
+	map->n_tiles--;
+}
+
+
+/// Aux function: new blank cells, for a tile of it's own
+static TileCells *BlankCells () {
+	TileCells *cells = (TileCells *) malloc (sizeof (TileCells));
+	cells->refs = 1;
+	FillRect (&(MOSAIC) {TILE_SIZE, TILE_SIZE, cells->chars, cells->attrs},
+			0, 0, TILE_SIZE - 1, TILE_SIZE - 1, ' ', Normal,
+			FILL_CH | FILL_ATTR);
+	return cells;
+}
+
+
+/// Aux function: makes the tile's cells it's own, copying them if they're
+/// shared, so they can be written
+static void Unshare (Tile *tile) {
+	if (tile->cells->refs > 1) {
+		TileCells *copy = (TileCells *) malloc (sizeof (TileCells));
+		memcpy (copy, tile->cells, sizeof (TileCells));
+		copy->refs = 1;
+		tile->cells->refs--;
+		tile->cells = copy;
+	}
+}
+
+
+/// Aux function: is every cell in the tile blank?
+static int BlankTile (Tile *tile) {
+	int i;
+	for (i = 0; i < TILE_SIZE * TILE_SIZE; i++) {
+		if (!IS_BLANK (tile->cells->chars[i], tile->cells->attrs[i])) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+
+Tile *FindTile (TileMap *map, int y, int x) {
+	const int ty = y / TILE_SIZE, tx = x / TILE_SIZE;
+	Tile *tile;
+	for (tile = map->buckets[Bucket (map, ty, tx)]; tile; tile = tile->next) {
+		if (tile->ty == ty && tile->tx == tx) {
+			return tile;
+		}
+	}
+
+	return NULL;
+}
+
+
+TileMap *CopyTileMap (TileMap *map) {
+	TileMap *copy = NewTileMap (map->height, map->width);
+	int i;
+	Tile *tile;
+	for (i = 0; i < map->n_buckets; i++) {
+		for (tile = map->buckets[i]; tile; tile = tile->next) {
+			tile->cells->refs++;
+			AddTile (copy, tile->ty, tile->tx, tile->cells);
+		}
+	}
+
+	return copy;
+}
+
+
+void ResizeTileMap (TileMap *map, int height, int width) {
+	int i;
+	Tile *tile, *aux;
+	for (i = 0; i < map->n_buckets; i++) {
+		for (tile = map->buckets[i]; tile; tile = aux) {
+			aux = tile->next;
+			const int y = tile->ty * TILE_SIZE, x = tile->tx * TILE_SIZE;
+			// all outside: bye bye
+			if (y >= height || x >= width) {
+				RemoveTile (map, tile);
+			}
+			// partly outside: blank what's out
+			else if (y + TILE_SIZE > height || x + TILE_SIZE > width) {
+				Unshare (tile);
+				MOSAIC cells = {TILE_SIZE, TILE_SIZE, tile->cells->chars,
+						tile->cells->attrs};
+				FillRect (&cells, height - y, 0, TILE_SIZE - 1, TILE_SIZE - 1,
+						' ', Normal, FILL_CH | FILL_ATTR);
+				FillRect (&cells, 0, width - x, TILE_SIZE - 1, TILE_SIZE - 1,
+						' ', Normal, FILL_CH | FILL_ATTR);
+				if (BlankTile (tile)) {
+					RemoveTile (map, tile);
+				}
+			}
+		}
+	}
+
+	map->height = height;
+	map->width = width;
+}
+
+
+void ReadTiles (TileMap *map, MOSAIC *view, int y, int x) {
+	// blank it all, then copy only the existing tiles' parts
+	FillRect (view, 0, 0, view->height - 1, view->width - 1, ' ', Normal,
+			FILL_CH | FILL_ATTR);
+
+	int ty, tx;
+	for (ty = y / TILE_SIZE; ty * TILE_SIZE < y + view->height; ty++) {
+		for (tx = x / TILE_SIZE; tx * TILE_SIZE < x + view->width; tx++) {
+			Tile *tile = FindTile (map, ty * TILE_SIZE, tx * TILE_SIZE);
+			if (!tile) {
+				continue;
+			}
+			// the tile's part inside the view, in canvas coordinates
+			int ULy = ty * TILE_SIZE, ULx = tx * TILE_SIZE;
+			int BRy = ULy + TILE_SIZE - 1, BRx = ULx + TILE_SIZE - 1;
+			ULy = max (ULy, y);
+			ULx = max (ULx, x);
+			BRy = min (BRy, y + view->height - 1);
+			BRx = min (BRx, x + view->width - 1);
+
+			int i;
+			const int n = BRx - ULx + 1;
+			for (i = ULy; i <= BRy; i++) {
+				const int from = (i - ty * TILE_SIZE) * TILE_SIZE + ULx - tx * TILE_SIZE;
+				const int to = MOS_INDEX (view, i - y, ULx - x);
+				memcpy (view->mosaic + to, tile->cells->chars + from,
+						n * sizeof (mos_char));
+				memcpy (view->attr + to, tile->cells->attrs + from,
+						n * sizeof (mos_attr));
+			}
+		}
+	}
+}
+
+
+void WriteTiles (TileMap *map, MOSAIC *view, int y, int x) {
+	// only what's inside the map is stored
+	const int bottom = min (y + view->height, map->height);
+	const int right = min (x + view->width, map->width);
+	if (y >= bottom || x >= right) {
+		return;
+	}
+
+	int ty, tx;
+	for (ty = y / TILE_SIZE; ty * TILE_SIZE < bottom; ty++) {
+		for (tx = x / TILE_SIZE; tx * TILE_SIZE < right; tx++) {
+			int ULy = ty * TILE_SIZE, ULx = tx * TILE_SIZE;
+			int BRy = ULy + TILE_SIZE - 1, BRx = ULx + TILE_SIZE - 1;
+			ULy = max (ULy, y);
+			ULx = max (ULx, x);
+			BRy = min (BRy, bottom - 1);
+			BRx = min (BRx, right - 1);
+
+			int i, j;
+			Tile *tile = FindTile (map, ULy, ULx);
+			// no tile there: create it only if there's something to store
+			if (!tile) {
+				int blank = 1;
+				for (i = ULy; i <= BRy && blank; i++) {
+					for (j = ULx; j <= BRx; j++) {
+						const int k = MOS_INDEX (view, i - y, j - x);
+						if (!IS_BLANK (view->mosaic[k], view->attr[k])) {
+							blank = 0;
+							break;
+						}
+					}
+				}
+				if (blank) {
+					continue;
+				}
+				tile = AddTile (map, ty, tx, BlankCells ());
+			}
+
+			const int n = BRx - ULx + 1;
+			// nothing changed: leave it be, shared or not
+			for (i = ULy; i <= BRy; i++) {
+				const int at = (i - ty * TILE_SIZE) * TILE_SIZE + ULx - tx * TILE_SIZE;
+				const int from = MOS_INDEX (view, i - y, ULx - x);
+				if (memcmp (tile->cells->chars + at, view->mosaic + from,
+							n * sizeof (mos_char))
+						|| memcmp (tile->cells->attrs + at, view->attr + from,
+							n * sizeof (mos_attr))) {
+					break;
+				}
+			}
+			if (i > BRy) {
+				continue;
+			}
+
+			Unshare (tile);
+			for (; i <= BRy; i++) {
+				const int to = (i - ty * TILE_SIZE) * TILE_SIZE + ULx - tx * TILE_SIZE;
+				const int from = MOS_INDEX (view, i - y, ULx - x);
+				memcpy (tile->cells->chars + to, view->mosaic + from,
+						n * sizeof (mos_char));
+				memcpy (tile->cells->attrs + to, view->attr + from,
+						n * sizeof (mos_attr));
+			}
+			// everything was erased: no need to keep it
+			if (BlankTile (tile)) {
+				RemoveTile (map, tile);
+			}
+		}
+	}
+}
+
+
+size_t TileMapBytes (TileMap *map) {
+	size_t bytes = sizeof (TileMap) + map->n_buckets * sizeof (Tile *)
+			+ map->n_tiles * sizeof (Tile);
+	int i;
+	Tile *tile;
+	for (i = 0; i < map->n_buckets; i++) {
+		for (tile = map->buckets[i]; tile; tile = tile->next) {
+			bytes += sizeof (TileCells) / tile->cells->refs;
+		}
+	}
+	return bytes;
+}
@@ -0,0 +1,471 @@
+#include "video.h"
+#include "maae.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Bytes before the first frame
+#define HEADER_SIZE 24
+/// Bytes before a frame's data
+#define FRAME_HEADER_SIZE 16
+/// Bytes per frame in the index
+#define INDEX_ENTRY_SIZE 16
+/// Bytes per char, in the file
+#define CHAR_SIZE 1
+/// Bytes per attribute, in the file
+#define ATTR_SIZE 4
+/// Unchanged cells a delta's span goes over, rather than starting another
+#define MAX_SPAN_GAP 8
+/// Appended to the name of the file being saved, until it's complete
+#define TEMP_SUFFIX ".part"
+
+/// The frame types
+enum { KEYFRAME = 0, DELTA };
+
+
+/// Aux function: writes value's size low bytes, little-endian
+static void PutValue (unsigned char *out, uint64_t value, int size) {
+	int i;
+	for (i = 0; i < size; i++) {
+		out[i] = (value >> (8 * i)) & 0xff;
+	}
+}
+
+
+/// Aux function: reads a size bytes little-endian value
+static uint64_t GetValue (const unsigned char *in, int size) {
+	uint64_t value = 0;
+	int i;
+	for (i = size - 1; i >= 0; i--) {
+		value = (value << 8) | in[i];
+	}
+	return value;
+}
+
+
+int IsVideo (const char *file_name) {
+	char magic[4];
+	FILE *f = fopen (file_name, "rb");
+	if (!f) {
+		return 0;
+	}
+	const int ret = fread (magic, 1, 4, f) == 4 && !memcmp (magic, "MOSV", 4);
+	fclose (f);
+
+	return ret;
+}
+
+
+int VideoName (const char *file_name) {
+	const char *dot = strrchr (file_name, '.');
+	return dot && !strcmp (dot, VIDEO_EXTENSION);
+}
+
+
+/// Aux function: frame n's offset, from the index
+static uint64_t FrameOffset (VideoFile *video, int n) {
+	return GetValue (video->data + video->index + INDEX_ENTRY_SIZE * (size_t) n, 8);
+}
+
+
+/// Aux function: frame n's keyframe, from the index
+static int FrameKey (VideoFile *video, int n) {
+	return GetValue (video->data + video->index + INDEX_ENTRY_SIZE * (size_t) n + 8, 4);
+}
+
+
+int OpenVideo (VideoFile *video, const char *file_name) {
+	int fd = open (file_name, O_RDONLY);
+	if (fd < 0) {
+		return errno;
+	}
+	struct stat info;
+	if (fstat (fd, &info)) {
+		const int err = errno;
+		close (fd);
+		return err;
+	}
+	video->size = info.st_size;
+	if (video->size < HEADER_SIZE) {
+		close (fd);
+		return ENODIMENSIONS;
+	}
+	void *data = mmap (NULL, video->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// the mapping stays valid without the descriptor
+	close (fd);
+	if (data == MAP_FAILED) {
+		return errno;
+	}
+	video->data = (const unsigned char *) data;
+
+	if (memcmp (video->data, "MOSV", 4)) {
+		CloseVideo (video);
+		return ENODIMENSIONS;
+	}
+	video->frames = GetValue (video->data + 8, 4);
+	video->index = GetValue (video->data + 16, 8);
+	if (video->data[4] != VIDEO_VERSION || video->frames < 0
+			|| video->index < HEADER_SIZE || video->index > video->size
+			|| (video->size - video->index) / INDEX_ENTRY_SIZE
+					< (size_t) video->frames) {
+		CloseVideo (video);
+		return EBADMSG;
+	}
+
+	// frames must be before the index, and their keyframes before them
+	int n;
+	for (n = 0; n < video->frames; n++) {
+		if (FrameOffset (video, n) < HEADER_SIZE
+				|| FrameOffset (video, n) + FRAME_HEADER_SIZE > video->index
+				|| FrameKey (video, n) > n) {
+			CloseVideo (video);
+			return EBADMSG;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * Aux function: decodes frame n over img, that must have the frame
+ * before it if n is a delta
+ *
+ * @return 0, or EBADMSG if the frame is corrupted (or img isn't it's base)
+ */
+static int DecodeFrame (VideoFile *video, int n, MOSAIC *img) {
+	const unsigned char *frame = video->data + FrameOffset (video, n);
+	const int type = frame[0];
+	const uint64_t height = GetValue (frame + 4, 4), width = GetValue (frame + 8, 4);
+	const uint64_t len = GetValue (frame + 12, 4);
+	const unsigned char *in = frame + FRAME_HEADER_SIZE;
+	if (len > video->data + video->index - in
+			|| height > MAX_CANVAS_SIDE || width > MAX_CANVAS_SIDE) {
+		return EBADMSG;
+	}
+	const size_t cells = height * width;
+
+	if (type == KEYFRAME) {
+		// a control byte and a char are 128 chars at most
+		if (cells / 64 > len || cells > INT_MAX) {
+			return EBADMSG;
+		}
+		uint32_t *vals = (uint32_t *) malloc ((cells + 1) * sizeof (uint32_t));
+		if (!vals || ResizeMOSAIC (img, height, width)) {
+			free (vals);
+			return ENOMEM;
+		}
+		int ret = EBADMSG;
+		size_t i, used = UnpackValues (in, len, cells, CHAR_SIZE, vals);
+		if (used || cells == 0) {
+			for (i = 0; i < cells; i++) {
+				img->mosaic[i] = vals[i];
+			}
+			if (UnpackValues (in + used, len - used, cells, ATTR_SIZE, vals)
+					|| cells == 0) {
+				for (i = 0; i < cells; i++) {
+					img->attr[i] = vals[i];
+				}
+				ret = 0;
+			}
+		}
+		free (vals);
+		return ret;
+	}
+
+	if (type != DELTA || len < 4 || (uint64_t) img->height != height
+			|| (uint64_t) img->width != width) {
+		return EBADMSG;
+	}
+	const uint64_t spans = GetValue (in, 4);
+	size_t p = 4, at = 0;
+	uint32_t *vals = NULL;
+	uint64_t s;
+	int ret = EBADMSG;
+	for (s = 0; s < spans; s++) {
+		if (len - p < 8) {
+			break;
+		}
+		const uint64_t skip = GetValue (in + p, 4), span = GetValue (in + p + 4, 4);
+		p += 8;
+		if (span == 0 || skip + span > cells - at) {
+			break;
+		}
+		at += skip;
+		uint32_t *more = (uint32_t *) realloc (vals, span * sizeof (uint32_t));
+		if (!more) {
+			ret = ENOMEM;
+			break;
+		}
+		vals = more;
+		size_t used = UnpackValues (in + p, len - p, span, CHAR_SIZE, vals), i;
+		if (!used) {
+			break;
+		}
+		for (i = 0; i < span; i++) {
+			img->mosaic[at + i] = vals[i];
+		}
+		p += used;
+		used = UnpackValues (in + p, len - p, span, ATTR_SIZE, vals);
+		if (!used) {
+			break;
+		}
+		for (i = 0; i < span; i++) {
+			img->attr[at + i] = vals[i];
+		}
+		p += used;
+		at += span;
+	}
+	free (vals);
+
+	return s == spans ? 0 : ret;
+}
+
+
+int ReadVideoFrame (VideoFile *video, int n, MOSAIC *img) {
+	if (n < 0 || n >= video->frames) {
+		return EINVAL;
+	}
+	int i, ret = 0;
+	for (i = FrameKey (video, n); i <= n && !ret; i++) {
+		ret = DecodeFrame (video, i, img);
+	}
+	return ret;
+}
+
+
+void CloseVideo (VideoFile *video) {
+	munmap ((void *) video->data, video->size);
+}
+
+
+/// Aux function: packs n chars, then their attributes, from cells on
+static size_t PackCells (MOSAIC *img, size_t from, size_t n, uint32_t *vals,
+		unsigned char *out) {
+	size_t i;
+	for (i = 0; i < n; i++) {
+		vals[i] = (unsigned char) img->mosaic[from + i];
+	}
+	size_t len = PackValues (vals, n, CHAR_SIZE, out);
+	for (i = 0; i < n; i++) {
+		vals[i] = img->attr[from + i];
+	}
+	return len + PackValues (vals, n, ATTR_SIZE, out + len);
+}
+
+
+/// Aux function: is cell i the same in a and b?
+static int SameCell (MOSAIC *a, MOSAIC *b, size_t i) {
+	return a->mosaic[i] == b->mosaic[i] && a->attr[i] == b->attr[i];
+}
+
+
+/**
+ * Aux function: encodes the spans of img that differ from prev
+ *
+ * @return The encoded length
+ */
+static size_t PackDelta (MOSAIC *img, MOSAIC *prev, uint32_t *vals,
+		unsigned char *out) {
+	const size_t cells = (size_t) img->height * img->width;
+	size_t len = 4, spans = 0, end = 0, i = 0;
+	while (i < cells) {
+		if (SameCell (img, prev, i)) {
+			i++;
+			continue;
+		}
+		// a span goes on over short gaps, that cost less than a new one
+		size_t last = i, j;
+		for (j = i + 1; j < cells && j - last <= MAX_SPAN_GAP; j++) {
+			if (!SameCell (img, prev, j)) {
+				last = j;
+			}
+		}
+		PutValue (out + len, i - end, 4);
+		PutValue (out + len + 4, last - i + 1, 4);
+		len += 8;
+		len += PackCells (img, i, last - i + 1, vals, out + len);
+		spans++;
+		end = i = last + 1;
+	}
+	PutValue (out, spans, 4);
+
+	return len;
+}
+
+
+/**
+ * Aux function: grows a buffer to size bytes, if it's smaller
+ *
+ * @return 0, or ENOMEM if it couldn't, the buffer left as it was
+ */
+static int Reserve (void **buffer, size_t *capacity, size_t size) {
+	if (size <= *capacity) {
+		return 0;
+	}
+	void *bigger = realloc (*buffer, size);
+	if (!bigger) {
+		return ENOMEM;
+	}
+	*buffer = bigger;
+	*capacity = size;
+	return 0;
+}
+
+
+int SaveVideo (IMGS *everyone, const char *file_name) {
+	const int frames = everyone->size;
+	unsigned char *index = (unsigned char *) calloc (frames + 1, INDEX_ENTRY_SIZE);
+	char *temp_name = (char *) malloc (strlen (file_name) + sizeof (TEMP_SUFFIX));
+	FILE *f = NULL;
+	int ret = ENOMEM;
+	if (index && temp_name) {
+		strcpy (temp_name, file_name);
+		strcat (temp_name, TEMP_SUFFIX);
+		f = fopen (temp_name, "wb");
+		ret = f ? 0 : errno;
+	}
+	if (!f) {
+		free (index);
+		free (temp_name);
+		return ret;
+	}
+
+	unsigned char header[HEADER_SIZE] = {'M', 'O', 'S', 'V', VIDEO_VERSION};
+	PutValue (header + 8, frames, 4);
+	fwrite (header, 1, HEADER_SIZE, f);
+
+	MOSAIC *prev = NULL;
+	char prev_copy = 0, copy;
+	uint32_t *vals = NULL;
+	unsigned char *out = NULL;
+	size_t vals_size = 0, out_size = 0;
+	uint64_t offset = HEADER_SIZE;
+	int n, key = 0;
+	for (n = 0; n < frames; n++) {
+		MOSAIC *img = WholeMOSAIC (GoToPage (everyone, n), &copy);
+		if (!img) {
+			ret = ENOMEM;
+			break;
+		}
+		const size_t cells = (size_t) img->height * img->width;
+		const char keyframe = n % DEFAULT_KEYFRAME_INTERVAL == 0
+				|| prev->height != img->height || prev->width != img->width;
+		// worst case: PackBits' control bytes for each value; and in deltas,
+		// each cell a span of it's own
+		const size_t worst = keyframe ? cells * (CHAR_SIZE + 1 + ATTR_SIZE + 1)
+				: 4 + cells * (8 + CHAR_SIZE + 1 + ATTR_SIZE + 1);
+		if (Reserve ((void **) &vals, &vals_size, (cells + 1) * sizeof (uint32_t))
+				|| Reserve ((void **) &out, &out_size, FRAME_HEADER_SIZE + worst)) {
+			if (copy) {
+				FreeMOSAIC (img);
+			}
+			ret = ENOMEM;
+			break;
+		}
+
+		size_t len;
+		if (keyframe) {
+			key = n;
+			len = PackCells (img, 0, cells, vals, out + FRAME_HEADER_SIZE);
+		}
+		else {
+			len = PackDelta (img, prev, vals, out + FRAME_HEADER_SIZE);
+		}
+		memset (out, 0, FRAME_HEADER_SIZE);
+		out[0] = keyframe ? KEYFRAME : DELTA;
+		PutValue (out + 4, img->height, 4);
+		PutValue (out + 8, img->width, 4);
+		PutValue (out + 12, len, 4);
+		fwrite (out, 1, FRAME_HEADER_SIZE + len, f);
+
+		PutValue (index + INDEX_ENTRY_SIZE * (size_t) n, offset, 8);
+		PutValue (index + INDEX_ENTRY_SIZE * (size_t) n + 8, key, 4);
+		offset += FRAME_HEADER_SIZE + len;
+
+		if (prev_copy) {
+			FreeMOSAIC (prev);
+		}
+		prev = img;
+		prev_copy = copy;
+	}
+	if (prev_copy) {
+		FreeMOSAIC (prev);
+	}
+	if (!ret) {
+		fwrite (index, 1, INDEX_ENTRY_SIZE * (size_t) frames, f);
+		// now the index' place is known
+		PutValue (header + 16, offset, 8);
+		fseek (f, 0, SEEK_SET);
+		fwrite (header, 1, HEADER_SIZE, f);
+		ret = ferror (f) ? (errno ? errno : EIO) : 0;
+	}
+
+	free (vals);
+	free (out);
+	free (index);
+
+	if (fclose (f) && !ret) {
+		ret = errno;
+	}
+	if (!ret && rename (temp_name, file_name)) {
+		ret = errno;
+	}
+	if (ret) {
+		remove (temp_name);
+	}
+	free (temp_name);
+
+	return ret;
+}
+
+
+int LoadVideo (IMGS *everyone, CURS_MOS *current, const char *file_name,
+		CURS_MOS **first) {
+	VideoFile video;
+	int ret = OpenVideo (&video, file_name);
+	if (ret) {
+		return ret;
+	}
+
+	// frames are decoded in order, each over the one before
+	MOSAIC *frame = NewMOSAIC (0, 0);
+	int n;
+	for (n = 0; n < video.frames && !ret; n++) {
+		ret = DecodeFrame (&video, n, frame);
+		if (ret) {
+			break;
+		}
+
+		CURS_MOS *img;
+		// too big to be kept whole: make it a canvas
+		if (frame->height > MAX_DENSE_SIDE || frame->width > MAX_DENSE_SIDE) {
+			img = NewCanvas (frame->height, frame->width);
+			// written, not set: a new canvas has nothing to undo
+			WriteCanvasCells (GetCanvas (img), frame, 0, 0);
+		}
+		else {
+			img = NewCURS_MOS (frame->height, frame->width);
+			CopyMOSAIC (img->img, frame);
+		}
+		// it's pad is shown as soon as it's the current one
+		RewriteCURS_MOS (img);
+		AddPage (everyone, current, img, after);
+		current = img;
+		if (n == 0) {
+			*first = img;
+		}
+	}
+	FreeMOSAIC (frame);
+	CloseVideo (&video);
+
+	return ret;
+}
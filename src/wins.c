@@ -1,4 +1,5 @@
 #include "wins.h"
+#include "canvas.h"
 
 // Special Windows definitions (it was too big all here)
 #include "hud.c"
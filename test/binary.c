@@ -0,0 +1,187 @@
+/** @file binary.c
+ * Binary files: PackBits round trips, with runs and literal sequences
+ * around the 128 values a control byte holds, and SaveBinary/LoadBinary
+ * round trips, with empty, truncated and corrupted files
+ */
+
+#include "maae.h"
+#include "binary.h"
+#include "test.h"
+
+#include <errno.h>
+#include <stdint.h>
+
+/// Aux function: packs and unpacks n values, checking they come back
+/// (and how long they got, if expected isn't 0)
+static void RoundTrip (const uint32_t *vals, int n, int size, size_t expected) {
+	unsigned char *packed = (unsigned char *) malloc ((size_t) n * (size + 1) + 1);
+	uint32_t *back = (uint32_t *) malloc (((size_t) n + 1) * sizeof (uint32_t));
+	const size_t len = PackValues (vals, n, size, packed);
+	CHECK (len <= (size_t) n * (size + 1));
+	if (expected) {
+		CHECK (len == expected);
+	}
+	CHECK (UnpackValues (packed, len, n, size, back) == len);
+	CHECK (n == 0 || !memcmp (back, vals, n * sizeof (uint32_t)));
+	// short of a byte, the data is corrupted
+	if (len > 0) {
+		CHECK (UnpackValues (packed, len - 1, n, size, back) == 0);
+	}
+	free (packed);
+	free (back);
+}
+
+
+/// Aux function: n values, in runs of run equal ones (1 for all different)
+static uint32_t *Values (int n, int run, uint32_t max) {
+	uint32_t *vals = (uint32_t *) malloc (((size_t) n + 1) * sizeof (uint32_t));
+	int i;
+	for (i = 0; i < n; i++) {
+		vals[i] = (i / run) % max;
+	}
+	return vals;
+}
+
+
+static void TestPackBits () {
+	// a run of 128 takes a control byte and the value, 129 need another
+	// pair for the last one (a literal)
+	const int runs[] = {2, 127, 128, 129, 256, 257};
+	int i;
+	for (i = 0; i < 6; i++) {
+		uint32_t *vals = Values (runs[i], runs[i], 256);
+		RoundTrip (vals, runs[i], 1, 2 * ((runs[i] + 127) / 128));
+		RoundTrip (vals, runs[i], 4, 5 * ((runs[i] + 127) / 128));
+		free (vals);
+	}
+
+	// literals: 128 fit a control byte, then another one starts
+	const int literals[] = {1, 127, 128, 129, 300};
+	for (i = 0; i < 5; i++) {
+		uint32_t *vals = Values (literals[i], 1, 256);
+		RoundTrip (vals, literals[i], 1, literals[i]
+				+ (literals[i] + 127) / 128);
+		RoundTrip (vals, literals[i], 4, 4 * literals[i]
+				+ (literals[i] + 127) / 128);
+		free (vals);
+	}
+
+	// runs and literals mixed, and values that need all 4 bytes
+	uint32_t mixed[1000];
+	for (i = 0; i < 1000; i++) {
+		mixed[i] = (i % 7 < 3 ? i : i / 7) * 0x01010101u;
+	}
+	RoundTrip (mixed, 1000, 4, 0);
+	RoundTrip (mixed, 0, 4, 0);
+
+	// 128 is a no-op; more values than asked for are corrupted data
+	const unsigned char noop[] = {128, 257 - 3, 'a'};
+	uint32_t back[4];
+	CHECK (UnpackValues (noop, 3, 3, 1, back) == 3);
+	CHECK (back[0] == 'a' && back[2] == 'a');
+	CHECK (UnpackValues (noop, 3, 2, 1, back) == 0);
+}
+
+
+/// Aux function: an image with runs, literals and every attribute bit
+static MOSAIC *TestImage (int height, int width) {
+	MOSAIC *img = NewMOSAIC (height, width);
+	int i;
+	for (i = 0; i < height * width; i++) {
+		img->mosaic[i] = i % 300 < 150 ? 'a' + i % 26 : ' ';
+		img->attr[i] = i % 5 == 0 ? Normal : (mos_attr) (i / 3 * 2654435761u);
+	}
+	return img;
+}
+
+
+/// Aux function: overwrites the file with it's first size bytes, patched
+static void Rewrite (const char *file_name, const unsigned char *data,
+		size_t size) {
+	FILE *f = fopen (file_name, "wb");
+	fwrite (data, 1, size, f);
+	fclose (f);
+}
+
+
+static void TestFiles () {
+	char *name = TempName (BINARY_EXTENSION);
+	const int sizes[][2] = {{40, 333}, {1, 1}, {5, 0}, {0, 7}, {0, 0}};
+	int i;
+	for (i = 0; i < 5; i++) {
+		MOSAIC *img = TestImage (sizes[i][0], sizes[i][1]);
+		MOSAIC *back = NewMOSAIC (3, 3);
+		int rows = -1;
+		CHECK (SaveBinary (img, name, &rows) == 0);
+		CHECK (rows == (sizes[i][0] ? sizes[i][0] : -1));
+		CHECK (IsBinary (name));
+		CHECK (LoadBinary (back, name) == 0);
+		CHECK (Same (img, back));
+		FreeMOSAIC (img);
+		FreeMOSAIC (back);
+	}
+
+	// a small image, whose every truncation is caught
+	MOSAIC *img = TestImage (6, 70);
+	MOSAIC *back = NewMOSAIC (0, 0);
+	CHECK (SaveBinary (img, name, NULL) == 0);
+	FILE *f = fopen (name, "rb");
+	unsigned char data[4096];
+	const size_t size = fread (data, 1, sizeof (data), f);
+	fclose (f);
+	CHECK (size > 0 && size < sizeof (data));
+	size_t len;
+	for (len = 0; len < size; len++) {
+		Rewrite (name, data, len);
+		CHECK (LoadBinary (back, name) != 0);
+	}
+
+	// a side too big, even if the index is fine (width 0, rows empty)
+	const int height = MAX_CANVAS_SIDE + 1;
+	const size_t big_size = 16 + 8 * ((size_t) height + 1);
+	unsigned char *big = (unsigned char *) calloc (big_size, 1);
+	memcpy (big, data, 8);
+	big[8] = height & 0xff;
+	big[9] = (height >> 8) & 0xff;
+	big[10] = (height >> 16) & 0xff;
+	for (len = 16; len < big_size; len += 8) {
+		big[len] = big_size & 0xff;
+		big[len + 1] = (big_size >> 8) & 0xff;
+		big[len + 2] = (big_size >> 16) & 0xff;
+	}
+	Rewrite (name, big, big_size);
+	BinaryFile file;
+	CHECK (OpenBinary (&file, name) == EBADMSG);
+	// the same file, with a height that fits, is fine
+	big[8] = big[9] = 1;
+	big[10] = 0;
+	Rewrite (name, big, big_size);
+	CHECK (OpenBinary (&file, name) == 0);
+	CloseBinary (&file);
+	free (big);
+
+	// a row's control byte saying there are more chars than the width
+	unsigned char bad[4096];
+	memcpy (bad, data, size);
+	const size_t first_row = 16 + 8 * (img->height + 1);
+	bad[first_row] = 200;
+	Rewrite (name, bad, size);
+	CHECK (LoadBinary (back, name) == EBADMSG);
+
+	// the untouched file is still fine
+	Rewrite (name, data, size);
+	CHECK (LoadBinary (back, name) == 0);
+	CHECK (Same (img, back));
+
+	FreeMOSAIC (img);
+	FreeMOSAIC (back);
+	remove (name);
+	free (name);
+}
+
+
+int main () {
+	TestPackBits ();
+	TestFiles ();
+	return TEST_RESULT ();
+}
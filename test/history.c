@@ -0,0 +1,241 @@
+/** @file history.c
+ * Undo and redo: typing runs, steps joined across images, eviction under
+ * the memory cap (with canvas snapshots counted as the canvas stops
+ * sharing their tiles), and range edits over many images (with a canvas
+ * left out), undone and redone at once
+ */
+
+#include "maae.h"
+#include "test.h"
+
+/// How many images the range edits go over
+#define FRAMES 100
+/// Their dimensions
+#define HEIGHT 40
+#define WIDTH 100
+
+
+/// Aux function: the char at y/x
+static mos_char At (CURS_MOS *img, int y, int x) {
+	return img->img->mosaic[MOS_INDEX (img->img, y, x)];
+}
+
+
+/// Aux function: typing runs and steps joined across images
+static void TestSteps () {
+	CURS_MOS *a = NewCURS_MOS (10, 10), *b = NewCURS_MOS (10, 10);
+	FillRect (a->img, 0, 0, 9, 9, '.', Normal, FILL_CH | FILL_ATTR);
+	FillRect (b->img, 0, 0, 9, 9, '.', Normal, FILL_CH | FILL_ATTR);
+
+	// a typing run is one step; a jump starts another
+	Edit (a, 0, 0, 'a', 1);
+	Edit (a, 0, 1, 'b', 1);
+	Edit (a, 0, 2, 'c', 1);
+	Edit (a, 5, 5, 'd', 1);
+	CHECK (Undo () == a);
+	CHECK (At (a, 5, 5) == '.' && At (a, 0, 2) == 'c');
+	CHECK (Undo () == a);
+	CHECK (At (a, 0, 0) == '.' && At (a, 0, 2) == '.');
+	CHECK (Undo () == NULL);
+	CHECK (Redo () == a);
+	CHECK (At (a, 0, 0) == 'a' && At (a, 0, 2) == 'c' && At (a, 5, 5) == '.');
+
+	// joined: undone and redone together, back on the first image
+	JoinEdits (1);
+	Edit (a, 1, 1, 'x', 0);
+	Edit (b, 2, 2, 'y', 0);
+	Edit (a, 3, 3, 'z', 0);
+	JoinEdits (0);
+	Edit (b, 9, 9, 'w', 0);
+	CHECK (Undo () == b);
+	CHECK (At (b, 9, 9) == '.' && At (b, 2, 2) == 'y');
+	CHECK (Undo () == a);
+	CHECK (At (a, 1, 1) == '.' && At (b, 2, 2) == '.' && At (a, 3, 3) == '.');
+	CHECK (At (a, 0, 0) == 'a');
+	CHECK (Redo () == a);
+	CHECK (At (a, 1, 1) == 'x' && At (b, 2, 2) == 'y' && At (a, 3, 3) == 'z');
+	CHECK (At (b, 9, 9) == '.');
+	// a new edit forgets what could be redone
+	Edit (b, 8, 8, 'v', 0);
+	CHECK (Redo () == NULL);
+
+	DestroyHistory ();
+	DiscardDirty (a);
+	DiscardDirty (b);
+	FreeCURS_MOS (a);
+	FreeCURS_MOS (b);
+}
+
+
+/// Aux function: the oldest steps go when over the cap
+static void TestEviction () {
+	CURS_MOS *img = NewCURS_MOS (HEIGHT, WIDTH);
+	SetHistoryLimit (64);
+	// 40x100 cells, about 12 KB a step
+	int i, undone;
+	for (i = 0; i < 20; i++) {
+		BeginEdit (img, 0);
+		RecordRect (img, 0, 0, HEIGHT - 1, WIDTH - 1);
+		FillRect (img->img, 0, 0, HEIGHT - 1, WIDTH - 1, 'a' + i, Normal,
+				FILL_CH | FILL_ATTR);
+	}
+	for (undone = 0; Undo (); undone++);
+	CHECK (undone > 0 && undone < 6);
+	// the evicted ones stay done
+	CHECK (At (img, 0, 0) == 'a' + 20 - undone - 1);
+
+	DestroyHistory ();
+	SetHistoryLimit (DEFAULT_HISTORY_KB);
+	DiscardDirty (img);
+	FreeCURS_MOS (img);
+}
+
+
+/// Aux function: a canvas snapshot grows as the canvas writes over it's
+/// shared tiles, and is evicted once that goes over the cap
+static void TestSnapshots () {
+	CURS_MOS *img = NewCanvas (256, 256);
+	Canvas *canvas = GetCanvas (img);
+	MOSAIC *cells = NewMOSAIC (256, 256);
+	FillRect (cells, 0, 0, 255, 255, 'a', Normal, FILL_CH | FILL_ATTR);
+	WriteCanvasCells (canvas, cells, 0, 0);
+	// 16 tiles of about 12 KB: half of them is the snapshot's, while shared
+	SetHistoryLimit (128);
+	RecordCanvas (img);
+	Edit (img, 0, 0, 'x', 0);
+	CHECK (Undo () == img && Undo () == img);
+	CHECK (Redo () == img && Redo () == img);
+
+	// now every tile is the snapshot's alone
+	FillRect (cells, 0, 0, 255, 255, 'b', Normal, FILL_CH | FILL_ATTR);
+	WriteCanvasCells (canvas, cells, 0, 0);
+	Edit (img, 1, 1, 'y', 0);
+	CHECK (Undo () == img);
+	CHECK (Undo () == img);
+	CHECK (Undo () == NULL);
+	ReadCanvasCells (canvas, cells, 0, 0);
+	CHECK (cells->mosaic[MOS_INDEX (cells, 200, 200)] == 'b');
+
+	FreeMOSAIC (cells);
+	DestroyHistory ();
+	SetHistoryLimit (DEFAULT_HISTORY_KB);
+	DestroyCanvases ();
+}
+
+
+/// Aux function: range edits, with a canvas among the images
+static void TestRanges () {
+	IMGS everyone;
+	InitIMGS (&everyone);
+	CURS_MOS *frames[FRAMES];
+	MOSAIC *original[FRAMES];
+	CURS_MOS *last = NULL;
+	int k, i, skipped;
+	for (k = 0; k < FRAMES; k++) {
+		if (k == 7) {
+			CURS_MOS *canvas = NewCanvas (2000, 2000);
+			AddPage (&everyone, last, canvas, after);
+			last = canvas;
+		}
+		frames[k] = NewCURS_MOS (HEIGHT, WIDTH);
+		MOSAIC *m = frames[k]->img;
+		for (i = 0; i < HEIGHT * WIDTH; i++) {
+			m->mosaic[i] = 'a' + (i + k) % 26;
+			m->attr[i] = (i + k) % 5;
+		}
+		RewriteCURS_MOS (frames[k]);
+		AddPage (&everyone, last, frames[k], after);
+		last = frames[k];
+		original[k] = NewMOSAIC (0, 0);
+		CopyMOSAIC (original[k], m);
+	}
+	CURS_MOS *current = frames[3];
+
+	// a keyed paste everywhere: blanks let the image show through
+	mos_char chars[6 * 20];
+	mos_attr attrs[6 * 20];
+	for (i = 0; i < 6 * 20; i++) {
+		chars[i] = i % 3 ? 'L' : ' ';
+		attrs[i] = i % 3 ? 9 : Normal;
+	}
+	RangeEdit paste = {RANGE_PASTE, {10, 50, 0, 0}, 0, 0,
+			{chars, attrs, 6, 20, 20}, {BLIT_KEY_CELL, ' ', Normal}};
+	CHECK (EditRange (&everyone, current, 0, everyone.size - 1, &paste, 0,
+				&skipped) == FRAMES);
+	CHECK (skipped == 1);
+	for (k = 0; k < FRAMES; k++) {
+		MOSAIC *m = frames[k]->img;
+		CHECK (At (frames[k], 10, 51) == 'L' && m->attr[MOS_INDEX (m, 10, 51)] == 9);
+		CHECK (At (frames[k], 10, 50) == original[k]->mosaic[MOS_INDEX (m, 10, 50)]);
+		// the others' pads are rewritten; the current one's is drawn
+		if (frames[k] != current) {
+			CHECK ((mvwinch (frames[k]->win, 10, 51) & A_CHARTEXT) == 'L');
+		}
+	}
+	// one undo takes it all back, landing on current
+	CHECK (Undo () == current);
+	for (k = 0; k < FRAMES; k++) {
+		CHECK (Same (frames[k]->img, original[k]));
+	}
+	CHECK (Redo () == current);
+	CHECK (At (frames[FRAMES - 1], 10, 51) == 'L');
+	CHECK (Undo () == current);
+
+	// a subrange, by one worker and by many
+	RangeEdit fill = {RANGE_FILL, {0, 0, HEIGHT - 1, WIDTH - 1}, '#', 4};
+	int jobs;
+	for (jobs = 1; jobs >= 0; jobs--) {
+		CHECK (EditRange (&everyone, current, 20, 60, &fill, jobs, &skipped) == 41);
+		// the canvas is at index 7: frames are one index behind from there
+		CHECK (At (frames[18], 0, 0) != '#' && At (frames[19], 5, 5) == '#');
+		CHECK (frames[59]->img->attr[7] == 4 && At (frames[60], 0, 0) != '#');
+		Undo ();
+	}
+	for (k = 0; k < FRAMES; k++) {
+		CHECK (Same (frames[k]->img, original[k]));
+	}
+
+	// recolor keeps the chars, erase blanks them
+	RangeEdit recolor = {RANGE_RECOLOR, {2, 2, 3, 3}, 0, 11};
+	RangeEdit erase = {RANGE_ERASE, {2, 2, 2, 2}};
+	EditRange (&everyone, current, 5, 5, &recolor, 0, &skipped);
+	EditRange (&everyone, current, 4, 6, &erase, 0, &skipped);
+	MOSAIC *five = frames[5]->img;
+	CHECK (five->attr[MOS_INDEX (five, 3, 3)] == 11);
+	CHECK (At (frames[5], 3, 3) == original[5]->mosaic[MOS_INDEX (five, 3, 3)]);
+	CHECK (At (frames[4], 2, 2) == ' ' && frames[6]->img->attr[MOS_INDEX (five, 2, 2)] == Normal);
+	Undo ();
+	Undo ();
+	for (k = 0; k < FRAMES; k++) {
+		CHECK (Same (frames[k]->img, original[k]));
+	}
+
+	// a range bigger than the cap stays undoable, and goes whole later
+	SetHistoryLimit (64);
+	EditRange (&everyone, current, 0, 50, &fill, 0, &skipped);
+	CHECK (Undo () == current);
+	CHECK (Same (frames[0]->img, original[0]) && Same (frames[49]->img, original[49]));
+	CHECK (Redo () == current);
+	Edit (current, 0, 0, '!', 0);
+	CHECK (Undo () == current);
+	CHECK (Undo () == NULL);
+	CHECK (At (frames[0], 0, 0) == '#' && At (frames[49], 0, 0) == '#');
+
+	for (k = 0; k < FRAMES; k++) {
+		FreeMOSAIC (original[k]);
+	}
+	DestroyHistory ();
+	DestroyCanvases ();
+	DestroyPages ();
+}
+
+
+int main () {
+	QuietCurses ();
+	TestSteps ();
+	TestEviction ();
+	TestSnapshots ();
+	TestRanges ();
+	endwin ();
+	return TEST_RESULT ();
+}
@@ -0,0 +1,194 @@
+/** @file journal.c
+ * Journaled saves: appending the changed cells and replaying them over the
+ * checkpoint, in ordinary images and canvases, with torn records, shape
+ * changes, the size limit and checkpoints rewritten behind our back
+ */
+
+#include "maae.h"
+#include "test.h"
+
+/// Aux function: fills img with runs of blanks and letters
+static void Fill (MOSAIC *img) {
+	const size_t cells = (size_t) img->height * img->width;
+	size_t i = 0;
+	while (i < cells) {
+		int run = 1 + rand () % 40;
+		const mos_char ch = rand () % 3 ? ' ' : 'a' + rand () % 26;
+		const mos_attr attr = rand () % 4 ? Normal : rand () % 26;
+		for ( ; run && i < cells; run--, i++) {
+			img->mosaic[i] = ch;
+			img->attr[i] = attr;
+		}
+	}
+}
+
+
+/// Aux function: saves img in the background, waiting for it to finish
+static int SaveAndWait (CURS_MOS *img, const char *file_name) {
+	int ret = StartSave (img, file_name);
+	if (ret == 0) {
+		AsyncKind kind;
+		CURS_MOS *target;
+		WaitAsync ();
+		ret = FinishAsync (&kind, &target);
+	}
+	return ret;
+}
+
+
+static void TestImage () {
+	char *name = TempName (BINARY_EXTENSION);
+	char journal[strlen (name) + sizeof (JOURNAL_SUFFIX)];
+	sprintf (journal, "%s%s", name, JOURNAL_SUFFIX);
+	CURS_MOS *img = NewCURS_MOS (300, 400);
+	MOSAIC *loaded = NewMOSAIC (0, 0);
+	Fill (img->img);
+
+	CHECK (SaveAndWait (img, name) == 0);
+	// nothing new, then a cell
+	CHECK (AppendJournal (img, name) == 0);
+	Edit (img, 150, 200, 'Q', 0);
+	CHECK (AppendJournal (img, name) == 0);
+	CHECK (access (journal, F_OK) == 0);
+	CHECK (LoadAnyMOSAIC (loaded, name) == 0);
+	CHECK (Same (loaded, img->img));
+
+	// a typing run, partly undone and redone
+	int i;
+	for (i = 0; i < 30; i++) {
+		Edit (img, 10, 100 + i, 'a' + i % 26, 0);
+	}
+	Undo ();
+	Undo ();
+	Redo ();
+	CHECK (AppendJournal (img, name) == 0);
+	CHECK (LoadAnyMOSAIC (loaded, name) == 0);
+	CHECK (Same (loaded, img->img));
+
+	// another file needs a checkpoint
+	char *other = TempName (BINARY_EXTENSION);
+	CHECK (AppendJournal (img, other) == ERR);
+	remove (other);
+	free (other);
+
+	// a record cut short at the end is left out of the replay...
+	FILE *f = fopen (journal, "ab");
+	fwrite ("\1\0\0\0\2\0\0\0\5\0\0\0\5\0\0\0abc", 1, 19, f);
+	fclose (f);
+	CHECK (LoadAnyMOSAIC (loaded, name) == 0);
+	CHECK (Same (loaded, img->img));
+	// ...but the journal isn't as we left it: checkpoint, that drops it
+	Edit (img, 3, 3, 'z', 0);
+	CHECK (AppendJournal (img, name) == ERR);
+	CHECK (SaveAndWait (img, name) == 0);
+	CHECK (access (journal, F_OK) != 0);
+	Edit (img, 4, 4, 'y', 0);
+	CHECK (AppendJournal (img, name) == 0);
+	CURS_MOS *other_img = NewCURS_MOS (0, 0);
+	CHECK (LoadAnyCURS_MOS (other_img, name) == 0);
+	CHECK (Same (other_img->img, img->img));
+
+	// a shape change needs a checkpoint
+	BeginEdit (img, 0);
+	RecordImage (img);
+	CHECK (AppendJournal (img, name) == ERR);
+
+	// and so does growing past the limit
+	CHECK (SaveAndWait (img, name) == 0);
+	for (i = 0; i < 200; i++) {
+		Edit (img, i, (i * 37) % 400, 'k', 0);
+	}
+	CHECK (AppendJournal (img, name) == 0);
+	SetJournalLimit (4);
+	for (i = 0; i < 200; i++) {
+		Edit (img, i + 1, (i * 37) % 400, 'k', 0);
+	}
+	CHECK (AppendJournal (img, name) == ERR);
+	SetJournalLimit (1024);
+
+	// the checkpoint rewritten some other way: the journal is ignored
+	CHECK (SaveAndWait (img, name) == 0);
+	Edit (img, 7, 7, 'w', 0);
+	CHECK (AppendJournal (img, name) == 0);
+	usleep (20000);
+	MOSAIC *outside = NewMOSAIC (300, 400);
+	Fill (outside);
+	CHECK (SaveBinary (outside, name, NULL) == 0);
+	CHECK (LoadAnyMOSAIC (loaded, name) == 0);
+	CHECK (Same (loaded, outside));
+	Edit (img, 8, 8, 'v', 0);
+	CHECK (AppendJournal (img, name) == ERR);
+
+	FreeMOSAIC (outside);
+	FreeMOSAIC (loaded);
+	remove (journal);
+	remove (name);
+	free (name);
+}
+
+
+static void TestCanvas () {
+	char *name = TempName (BINARY_EXTENSION);
+	MOSAIC *ref = NewMOSAIC (3000, 1500);
+	Fill (ref);
+	CHECK (SaveBinary (ref, name, NULL) == 0);
+
+	// mapped lazily, edited here and there
+	CURS_MOS *img = NewCURS_MOS (0, 0);
+	CHECK (LoadAnyCURS_MOS (img, name) == 0);
+	JournalAttach (img, name);
+	Canvas *canvas = GetCanvas (img);
+	CHECK (canvas && canvas->source);
+	int i;
+	for (i = 0; i < 20; i++) {
+		ShowCanvasAt (canvas, rand () % 3000, rand () % 1500);
+		Edit (img, rand () % img->img->height, rand () % img->img->width, 'Z', 0);
+	}
+	CHECK (AppendJournal (img, name) == 0);
+	// they're all canvases: their contents are copies
+	char copy;
+	MOSAIC *edited = WholeMOSAIC (img, &copy);
+
+	// the journal comes back in canvases, whole images and async loads
+	CURS_MOS *other = NewCURS_MOS (0, 0);
+	CHECK (LoadAnyCURS_MOS (other, name) == 0);
+	CHECK (GetCanvas (other) && GetCanvas (other)->source);
+	MOSAIC *loaded = WholeMOSAIC (other, &copy);
+	CHECK (Same (loaded, edited));
+	FreeMOSAIC (loaded);
+	loaded = NewMOSAIC (0, 0);
+	CHECK (LoadAnyMOSAIC (loaded, name) == 0);
+	CHECK (Same (loaded, edited));
+	FreeMOSAIC (loaded);
+	CURS_MOS *async = NewCURS_MOS (0, 0);
+	AsyncKind kind;
+	CURS_MOS *target;
+	CHECK (StartLoad (async, name) == 0);
+	WaitAsync ();
+	CHECK (FinishAsync (&kind, &target) == 0);
+	loaded = WholeMOSAIC (async, &copy);
+	CHECK (Same (loaded, edited));
+
+	FreeMOSAIC (loaded);
+	FreeMOSAIC (edited);
+	FreeMOSAIC (ref);
+	char journal[strlen (name) + sizeof (JOURNAL_SUFFIX)];
+	sprintf (journal, "%s%s", name, JOURNAL_SUFFIX);
+	remove (journal);
+	remove (name);
+	free (name);
+}
+
+
+int main () {
+	QuietCurses ();
+	srand (5);
+	SetJournalLimit (1024);
+	TestImage ();
+	TestCanvas ();
+	DestroyJournals ();
+	DestroyHistory ();
+	DestroyCanvases ();
+	endwin ();
+	return TEST_RESULT ();
+}
@@ -0,0 +1,102 @@
+/** @file onion.c
+ * Onion skin: the neighbours showing through the current image's blanks,
+ * dimmed, as it's typed over and erased, as the neighbours change, when
+ * changing pages and when turned off
+ */
+
+#include "maae.h"
+#include "test.h"
+
+/// The images' dimensions
+#define HEIGHT 80
+#define WIDTH 200
+
+
+/// Aux function: the char shown at y/x of img's pad
+static int CharAt (CURS_MOS *img, int y, int x) {
+	return mvwinch (img->win, y, x) & A_CHARTEXT;
+}
+
+
+/// Aux function: is the cell at y/x of img's pad dimmed?
+static int Dim (CURS_MOS *img, int y, int x) {
+	return (mvwinch (img->win, y, x) & A_DIM) != 0;
+}
+
+
+/// Aux function: writes a char in img, as the editor does
+static void Put (CURS_MOS *img, int y, int x, mos_char ch) {
+	img->img->mosaic[MOS_INDEX (img->img, y, x)] = ch;
+	MarkDirty (img, y, x, y, x);
+}
+
+
+int main () {
+	QuietCurses ();
+	start_color ();
+	InitColors ();
+	InitHud ();
+	IMGS everyone;
+	InitIMGS (&everyone);
+	CURS_MOS *frames[3], *last = NULL;
+	int k;
+	for (k = 0; k < 3; k++) {
+		frames[k] = NewCURS_MOS (HEIGHT, WIDTH);
+		FillRect (frames[k]->img, 0, 0, HEIGHT - 1, WIDTH - 1, ' ', Normal,
+				FILL_CH | FILL_ATTR);
+		AddPage (&everyone, last, frames[k], after);
+		last = frames[k];
+	}
+	CURS_MOS *prev = frames[0], *current = frames[1], *next = frames[2];
+	prev->img->mosaic[MOS_INDEX (prev->img, 5, 5)] = 'P';
+	next->img->mosaic[MOS_INDEX (next->img, 5, 6)] = 'N';
+	next->img->mosaic[MOS_INDEX (next->img, 5, 5)] = 'n';
+	current->img->mosaic[MOS_INDEX (current->img, 7, 7)] = 'C';
+	RewriteCURS_MOS (prev);
+	RewriteCURS_MOS (next);
+
+	ENTER_(REDRAW);
+	DisplayCurrent (current);
+	CHECK (CharAt (current, 5, 5) == ' ');
+
+	// the previous image wins where both show through
+	ENTER_(ONION);
+	DisplayCurrent (current);
+	CHECK (CharAt (current, 5, 5) == 'P' && Dim (current, 5, 5));
+	CHECK (CharAt (current, 5, 6) == 'N' && Dim (current, 5, 6));
+	CHECK (CharAt (current, 7, 7) == 'C' && !Dim (current, 7, 7));
+
+	// typed over, then erased
+	Put (current, 5, 5, 'x');
+	DisplayCurrent (current);
+	CHECK (CharAt (current, 5, 5) == 'x' && !Dim (current, 5, 5));
+	Put (current, 5, 5, ' ');
+	DisplayCurrent (current);
+	CHECK (CharAt (current, 5, 5) == 'P' && Dim (current, 5, 5));
+
+	// the neighbours edited
+	Put (prev, 5, 5, ' ');
+	Put (next, 9, 9, 'Z');
+	DisplayCurrent (current);
+	CHECK (CharAt (current, 5, 5) == 'n');
+	CHECK (CharAt (current, 9, 9) == 'Z' && Dim (current, 9, 9));
+
+	// on the next page, the old one loses it's ghosts
+	DisplayCurrent (next);
+	CHECK (CharAt (current, 5, 5) == ' ' && CharAt (current, 9, 9) == ' ');
+	CHECK (CharAt (next, 7, 7) == 'C' && Dim (next, 7, 7));
+	CHECK (CharAt (next, 9, 9) == 'Z' && !Dim (next, 9, 9));
+
+	// and turned off, none are left
+	DisplayCurrent (current);
+	CHECK (CharAt (current, 9, 9) == 'Z');
+	UN_(ONION);
+	DisplayCurrent (current);
+	CHECK (CharAt (current, 9, 9) == ' ' && CharAt (current, 5, 5) == ' ');
+	CHECK (CharAt (current, 7, 7) == 'C');
+
+	DestroyOnion ();
+	DestroyPages ();
+	endwin ();
+	return TEST_RESULT ();
+}
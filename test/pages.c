@@ -0,0 +1,54 @@
+/** @file pages.c
+ * The page table: images linked before and after random ones, checking
+ * that GoToPage and PageIndex agree with the circular list all along
+ */
+
+#include "maae.h"
+#include "test.h"
+
+/// How many images are linked
+#define PAGES 3000
+
+
+/// Aux function: does the table agree with the list, all around?
+static int Agrees (IMGS *everyone) {
+	CURS_MOS *img = everyone->list;
+	int i;
+	for (i = 0; i < everyone->size; i++, img = img->next) {
+		if (GoToPage (everyone, i) != img || PageIndex (everyone, img) != i) {
+			return 0;
+		}
+	}
+	return img == everyone->list;
+}
+
+
+int main () {
+	QuietCurses ();
+	IMGS everyone;
+	InitIMGS (&everyone);
+	srand (3);
+	CURS_MOS *current = NULL;
+	int n;
+	for (n = 0; n < PAGES; n++) {
+		CURS_MOS *img = NewCURS_MOS (1, 1);
+		AddPage (&everyone, current, img, rand () % 2 ? after : before);
+		// on to the new one, or to some other, or stay
+		if (!current || rand () % 3 == 0) {
+			current = img;
+		}
+		else if (rand () % 2) {
+			current = GoToPage (&everyone, rand () % everyone.size);
+		}
+		if (n < 50 || n % 500 == 0) {
+			CHECK (Agrees (&everyone));
+		}
+	}
+	CHECK (everyone.size == PAGES);
+	CHECK (Agrees (&everyone));
+	CHECK (GoToPage (&everyone, PAGES) == NULL);
+
+	DestroyPages ();
+	endwin ();
+	return TEST_RESULT ();
+}
@@ -0,0 +1,80 @@
+/** @file test.h
+ * What the tests share: checks that count failures, instead of aborting,
+ * and helpers to make and compare images (the benchmarks use some too)
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <curses.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "maae.h"
+
+/// Failed checks so far
+static inline int *Failures () {
+	static int failures = 0;
+	return &failures;
+}
+
+/// Checks cond, telling where it failed if it did
+#define CHECK(cond) do { \
+	if (!(cond)) { \
+		fprintf (stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+		(*Failures ())++; \
+	} \
+} while (0)
+
+/// What main returns: 1 if a check failed, so the test target fails
+#define TEST_RESULT() (*Failures () ? 1 : 0)
+
+/// Starts curses on a terminal that goes nowhere, for what needs pads
+static inline void QuietCurses () {
+	newterm ("xterm", fopen ("/dev/null", "w"), stdin);
+}
+
+/**
+ * A new temporary file's name, ending with suffix; the file is created
+ * empty, and should be removed (remove) when done
+ *
+ * @return The name, to be freed
+ */
+static inline char *TempName (const char *suffix) {
+	const char *dir = getenv ("TMPDIR") ? getenv ("TMPDIR") : "/tmp";
+	char *name = (char *) malloc (strlen (dir) + strlen (suffix) + 16);
+	sprintf (name, "%s/maaeXXXXXX%s", dir, suffix);
+	const int fd = mkstemps (name, strlen (suffix));
+	if (fd < 0) {
+		perror (name);
+		exit (1);
+	}
+	close (fd);
+	return name;
+}
+
+/// Are both images the same, dimensions and cells?
+static inline int Same (MOSAIC *a, MOSAIC *b) {
+	const size_t cells = (size_t) a->height * a->width;
+	return a->height == b->height && a->width == b->width
+			&& !memcmp (a->mosaic, b->mosaic, cells * sizeof (mos_char))
+			&& !memcmp (a->attr, b->attr, cells * sizeof (mos_attr));
+}
+
+/**
+ * Edits a cell, as the editor does: recorded for undo, then changed to ch,
+ * with an attribute made from it
+ *
+ * @param[in] coalesce Whether it may be merged with the last edit, as
+ * typing is (see BeginEdit)
+ */
+static inline void Edit (CURS_MOS *img, int y, int x, mos_char ch,
+		char coalesce) {
+	BeginEdit (img, coalesce);
+	RecordRect (img, y, x, y, x);
+	img->img->mosaic[MOS_INDEX (img->img, y, x)] = ch;
+	img->img->attr[MOS_INDEX (img->img, y, x)] = ch % 7;
+}
+
+#endif
@@ -0,0 +1,268 @@
+/** @file tiles.c
+ * Copy-on-write tiles: random writes, copies and frees over TileMaps
+ * checked against dense references, and duplicated images sharing their
+ * tiles, stowed while they're not shown, through edits, undo and ranges
+ */
+
+#include "maae.h"
+#include "test.h"
+
+/// The TileMaps' dimensions
+#define HEIGHT 300
+#define WIDTH 400
+/// How many TileMaps (and references) there are
+#define MAPS 4
+/// A duplicated frame's dimensions
+#define FRAME_HEIGHT 100
+#define FRAME_WIDTH 200
+/// How many times it's duplicated
+#define DUPLICATES 50
+
+
+/// Aux function: does the TileMap hold the same as the reference?
+static int Holds (TileMap *map, MOSAIC *ref) {
+	MOSAIC *all = NewMOSAIC (map->height, map->width);
+	ReadTiles (map, all, 0, 0);
+	const int same = Same (all, ref);
+	FreeMOSAIC (all);
+	return same;
+}
+
+
+/// Aux function: writes a random region, in the map and the reference
+static void WriteRandom (TileMap *map, MOSAIC *ref) {
+	const int height = 1 + rand () % 150, width = 1 + rand () % 150;
+	// some start before the map, and are cut
+	int y = rand () % (HEIGHT + 20) - 20, x = rand () % (WIDTH + 20) - 20;
+	y = max (y, 0);
+	x = max (x, 0);
+	MOSAIC *cells = NewMOSAIC (height, width);
+	ReadTiles (map, cells, y, x);
+	int i, n = rand () % 30;
+	for (i = 0; i < n; i++) {
+		const int k = rand () % (height * width);
+		cells->mosaic[k] = rand () % 3 ? 'a' + rand () % 26 : ' ';
+		cells->attr[k] = rand () % 2 ? Normal : rand () % 20;
+	}
+	// and all blank now and then, to free tiles
+	if (rand () % 5 == 0) {
+		FillRect (cells, 0, 0, height - 1, width - 1, ' ', Normal,
+				FILL_CH | FILL_ATTR);
+	}
+	WriteTiles (map, cells, y, x);
+
+	int a, b;
+	for (a = 0; a < height && y + a < HEIGHT; a++) {
+		for (b = 0; b < width && x + b < WIDTH; b++) {
+			const int to = MOS_INDEX (ref, y + a, x + b);
+			ref->mosaic[to] = cells->mosaic[MOS_INDEX (cells, a, b)];
+			ref->attr[to] = cells->attr[MOS_INDEX (cells, a, b)];
+		}
+	}
+	FreeMOSAIC (cells);
+}
+
+
+/// Aux function: copies, frees and writes maps at random
+static void TestCopyOnWrite () {
+	TileMap *maps[MAPS];
+	MOSAIC *refs[MAPS];
+	int k, it;
+	for (k = 0; k < MAPS; k++) {
+		maps[k] = k ? NULL : NewTileMap (HEIGHT, WIDTH);
+		refs[k] = NewMOSAIC (HEIGHT, WIDTH);
+	}
+	FillRect (refs[0], 0, 0, HEIGHT - 1, WIDTH - 1, ' ', Normal,
+			FILL_CH | FILL_ATTR);
+
+	for (it = 0; it < 1500; it++) {
+		const int op = rand () % 10;
+		k = rand () % MAPS;
+		if (!maps[k]) {
+			continue;
+		}
+		if (op == 0) {
+			const int to = rand () % MAPS;
+			if (to != k) {
+				FreeTileMap (maps[to]);
+				maps[to] = CopyTileMap (maps[k]);
+				CopyMOSAIC (refs[to], refs[k]);
+			}
+		}
+		else if (op == 1 && k) {
+			FreeTileMap (maps[k]);
+			maps[k] = NULL;
+		}
+		else {
+			WriteRandom (maps[k], refs[k]);
+		}
+		// a write in one must not show in the copies
+		for (k = 0; k < MAPS; k++) {
+			if (maps[k]) {
+				CHECK (Holds (maps[k], refs[k]));
+			}
+		}
+	}
+
+	for (k = 0; k < MAPS; k++) {
+		FreeTileMap (maps[k]);
+		FreeMOSAIC (refs[k]);
+	}
+}
+
+
+/// Aux function: the char at y/x of a canvas, read from the tiles
+static mos_char CharAt (CURS_MOS *img, int y, int x) {
+	MOSAIC *cell = NewMOSAIC (1, 1);
+	ReadCanvasCells (GetCanvas (img), cell, y, x);
+	const mos_char ch = cell->mosaic[0];
+	FreeMOSAIC (cell);
+	return ch;
+}
+
+
+/// Aux function: memory used by the tiles of every image
+static size_t AllTiles (IMGS *everyone) {
+	size_t bytes = 0;
+	int i;
+	for (i = 0; i < everyone->size; i++) {
+		bytes += TileMapBytes (GetCanvas (GoToPage (everyone, i))->tiles);
+	}
+	return bytes;
+}
+
+
+/// Aux function: duplicated images, as CreateNewMOSAIC does them
+static void TestDuplicates () {
+	IMGS everyone;
+	InitIMGS (&everyone);
+	CURS_MOS *frame = NewCURS_MOS (FRAME_HEIGHT, FRAME_WIDTH);
+	MOSAIC *ref = NewMOSAIC (FRAME_HEIGHT, FRAME_WIDTH);
+	int i;
+	for (i = 0; i < FRAME_HEIGHT * FRAME_WIDTH; i++) {
+		ref->mosaic[i] = 'a' + i % 26;
+		ref->attr[i] = i % 9;
+	}
+	CopyMOSAIC (frame->img, ref);
+	AddPage (&everyone, NULL, frame, after);
+
+	CURS_MOS *current = frame;
+	for (i = 0; i < DUPLICATES; i++) {
+		CURS_MOS *copy = DuplicateCanvas (MakeCanvas (current));
+		AddPage (&everyone, current, copy, after);
+		current = copy;
+		StowCanvases (current);
+	}
+	CHECK (WholeCanvas (frame) && WholeCanvas (current));
+	// the others keep only their tiles, all shared: one frame's worth, and
+	// a pointer per tile in each (dense copies would be a frame each)
+	CHECK (frame->img->height == 1 && frame->img->width == 1);
+	TileMap *alone = NewTileMap (FRAME_HEIGHT, FRAME_WIDTH);
+	WriteTiles (alone, ref, 0, 0);
+	const size_t one = TileMapBytes (alone);
+	FreeTileMap (alone);
+	const size_t shared = AllTiles (&everyone);
+	CHECK (shared < 2 * one);
+	for (i = 0; i <= DUPLICATES; i += 7) {
+		MOSAIC *whole = NewMOSAIC (FRAME_HEIGHT, FRAME_WIDTH);
+		ReadCanvasCells (GetCanvas (GoToPage (&everyone, i)), whole, 0, 0);
+		CHECK (Same (whole, ref));
+		FreeMOSAIC (whole);
+	}
+
+	// an edit copies one tile, and only in the image edited
+	Edit (current, 70, 150, '#', 0);
+	UnstowCanvas (frame);
+	StowCanvases (frame);
+	CHECK (current->img->height == 1);
+	CHECK (CharAt (current, 70, 150) == '#');
+	CHECK (CharAt (frame, 70, 150) == ref->mosaic[MOS_INDEX (ref, 70, 150)]);
+	CHECK (AllTiles (&everyone) <= shared + sizeof (TileCells));
+
+	// shown again, the view is the whole image, edit included
+	UnstowCanvas (current);
+	CHECK (current->img->height == FRAME_HEIGHT
+			&& current->img->width == FRAME_WIDTH);
+	CHECK (current->img->mosaic[MOS_INDEX (current->img, 70, 150)] == '#');
+
+	// undone in the tiles, it stays stowed
+	StowCanvases (frame);
+	CHECK (Undo () == current);
+	CHECK (current->img->height == 1);
+	CHECK (CharAt (current, 70, 150) == ref->mosaic[MOS_INDEX (ref, 70, 150)]);
+	CHECK (Redo () == current);
+	CHECK (CharAt (current, 70, 150) == '#');
+	UnstowCanvas (current);
+	CHECK (current->img->mosaic[MOS_INDEX (current->img, 70, 150)] == '#');
+	StowCanvases (frame);
+	Undo ();
+
+	// ranges edit them as ordinary images, and the stowed ones in the tiles
+	RangeEdit edit;
+	edit.op = RANGE_FILL;
+	edit.rect.ULy = edit.rect.ULx = 10;
+	edit.rect.BRy = edit.rect.BRx = 20;
+	edit.ch = '%';
+	edit.attr = 3;
+	int skipped;
+	CHECK (EditRange (&everyone, frame, 0, DUPLICATES, &edit, 2, &skipped)
+			== DUPLICATES + 1);
+	CHECK (skipped == 0);
+	for (i = 1; i <= DUPLICATES; i += 5) {
+		CHECK (GoToPage (&everyone, i)->img->height == 1);
+		CHECK (CharAt (GoToPage (&everyone, i), 15, 15) == '%');
+	}
+	CHECK (frame->img->mosaic[MOS_INDEX (frame->img, 15, 15)] == '%');
+	// each copied just the tile edited
+	CHECK (AllTiles (&everyone) <= shared + (DUPLICATES + 1) * sizeof (TileCells));
+	// and undone at once, still stowed
+	CHECK (Undo () == frame);
+	for (i = 0; i <= DUPLICATES; i += 5) {
+		CHECK (CharAt (GoToPage (&everyone, i), 15, 15)
+				== ref->mosaic[MOS_INDEX (ref, 15, 15)]);
+	}
+	CHECK (current->img->height == 1);
+
+	// pasted partly out of them
+	mos_char chars[4] = {'A', 'B', 'C', 'D'};
+	mos_attr attrs[4] = {1, 2, 3, 4};
+	edit.op = RANGE_PASTE;
+	edit.rect.ULy = edit.rect.ULx = -1;
+	edit.src.chars = chars;
+	edit.src.attrs = attrs;
+	edit.src.height = edit.src.width = edit.src.stride = 2;
+	edit.key.mode = BLIT_OPAQUE;
+	EditRange (&everyone, frame, 0, DUPLICATES, &edit, 1, &skipped);
+	CHECK (CharAt (current, 0, 0) == 'D' && CharAt (current, 0, 1) == ref->mosaic[1]);
+	CHECK (frame->img->mosaic[0] == 'D');
+	Undo ();
+	CHECK (CharAt (current, 0, 0) == ref->mosaic[0]);
+
+	// resized before it was duplicated: undone, the tiles follow
+	CURS_MOS *resized = NewCURS_MOS (30, 40);
+	AddPage (&everyone, current, resized, after);
+	BeginEdit (resized, 0);
+	RecordImage (resized);
+	ResizeCURS_MOS (resized, 50, 60);
+	AddPage (&everyone, resized, DuplicateCanvas (MakeCanvas (resized)), after);
+	CHECK (Undo () == resized);
+	Rect bounds;
+	CanvasBounds (resized, &bounds);
+	CHECK (bounds.BRy == 29 && bounds.BRx == 39);
+	CHECK (WholeCanvas (resized));
+
+	FreeMOSAIC (ref);
+	DestroyHistory ();
+	DestroyCanvases ();
+	DestroyPages ();
+}
+
+
+int main () {
+	srand (3);
+	TestCopyOnWrite ();
+	QuietCurses ();
+	TestDuplicates ();
+	endwin ();
+	return TEST_RESULT ();
+}
@@ -0,0 +1,174 @@
+/** @file video.c
+ * Video files: frames saved and read back at any position (keyframes,
+ * deltas, a change of dimensions, a canvas), whole loads, and truncated or
+ * corrupted files, that must fail without crashing
+ */
+
+#include "maae.h"
+#include "test.h"
+
+#include <errno.h>
+
+/// How many frames are saved
+#define FRAMES 300
+/// The frames that are shorter than the rest, forcing keyframes
+#define SHORT_FROM 100
+#define SHORT_TO 105
+/// The frame that is a canvas
+#define CANVAS_FRAME 170
+
+
+/// Aux function: does frame n of the video match img?
+static int FrameIs (VideoFile *video, int n, CURS_MOS *img) {
+	MOSAIC *frame = NewMOSAIC (0, 0);
+	char copy;
+	MOSAIC *whole = WholeMOSAIC (img, &copy);
+	const int same = ReadVideoFrame (video, n, frame) == 0 && Same (frame, whole);
+	if (copy) {
+		FreeMOSAIC (whole);
+	}
+	FreeMOSAIC (frame);
+	return same;
+}
+
+
+/// Aux function: an animation frame: dots, a moving block and it's number
+static CURS_MOS *NewFrame (int n) {
+	const int height = n >= SHORT_FROM && n < SHORT_TO ? 30 : 40;
+	CURS_MOS *img = n == CANVAS_FRAME ? NewCanvas (600, 150)
+			: NewCURS_MOS (height, 100);
+	MOSAIC *m = img->img;
+	int i, y, x;
+	for (i = 0; i < m->height * m->width; i++) {
+		m->mosaic[i] = i % 11 ? ' ' : '.';
+		m->attr[i] = (i / m->width) % 3;
+	}
+	for (y = 0; y < 6; y++) {
+		for (x = 0; x < 12; x++) {
+			const int cell = MOS_INDEX (m, (y + n / 3) % (m->height - 6),
+					(x + n) % (m->width - 12));
+			m->mosaic[cell] = '@';
+			m->attr[cell] = 5;
+		}
+	}
+	char number[16];
+	snprintf (number, sizeof (number), "%d", n);
+	memcpy (m->mosaic, number, strlen (number));
+	if (n == CANVAS_FRAME) {
+		// the view goes back to the tiles when it moves
+		ShowCanvasAt (GetCanvas (img), 400, 0);
+		img->img->mosaic[5] = 'C';
+	}
+	return img;
+}
+
+
+/// Aux function: writes size bytes of data to a file
+static void WriteFile (const char *file_name, const unsigned char *data,
+		size_t size) {
+	FILE *f = fopen (file_name, "wb");
+	fwrite (data, 1, size, f);
+	fclose (f);
+}
+
+
+int main () {
+	QuietCurses ();
+	srand (7);
+	IMGS everyone;
+	InitIMGS (&everyone);
+	CURS_MOS *current = NULL;
+	int n, i;
+	for (n = 0; n < FRAMES; n++) {
+		CURS_MOS *img = NewFrame (n);
+		AddPage (&everyone, current, img, after);
+		current = img;
+	}
+
+	char *name = TempName (VIDEO_EXTENSION);
+	CHECK (SaveVideo (&everyone, name) == 0);
+	CHECK (IsVideo (name) && VideoName (name));
+
+	// frames anywhere, in any order
+	VideoFile video;
+	CHECK (OpenVideo (&video, name) == 0);
+	CHECK (video.frames == FRAMES);
+	const int some[] = {0, 1, DEFAULT_KEYFRAME_INTERVAL - 1,
+			DEFAULT_KEYFRAME_INTERVAL, SHORT_FROM, SHORT_TO - 1, SHORT_TO,
+			CANVAS_FRAME, CANVAS_FRAME + 1, FRAMES - 1};
+	for (i = 0; i < (int) (sizeof (some) / sizeof (*some)); i++) {
+		CHECK (FrameIs (&video, some[i], GoToPage (&everyone, some[i])));
+	}
+	for (i = 0; i < 100; i++) {
+		n = rand () % FRAMES;
+		CHECK (FrameIs (&video, n, GoToPage (&everyone, n)));
+	}
+	MOSAIC *frame = NewMOSAIC (0, 0);
+	CHECK (ReadVideoFrame (&video, FRAMES, frame) == EINVAL);
+	CHECK (ReadVideoFrame (&video, -1, frame) == EINVAL);
+	CloseVideo (&video);
+
+	// all of it, after the last frame (the page index is for one IMGS)
+	CURS_MOS *first = NULL;
+	CHECK (LoadVideo (&everyone, current, name, &first) == 0);
+	CHECK (everyone.size == 2 * FRAMES && first == current->next);
+	for (n = 0; n < FRAMES; n++) {
+		CURS_MOS *saved = GoToPage (&everyone, n);
+		CURS_MOS *loaded = GoToPage (&everyone, FRAMES + n);
+		char copy_a, copy_b;
+		MOSAIC *a = WholeMOSAIC (saved, &copy_a);
+		MOSAIC *b = WholeMOSAIC (loaded, &copy_b);
+		CHECK (Same (a, b));
+		if (copy_a) {
+			FreeMOSAIC (a);
+		}
+		if (copy_b) {
+			FreeMOSAIC (b);
+		}
+	}
+
+	// truncated and corrupted files: errors, never crashes
+	FILE *f = fopen (name, "rb");
+	fseek (f, 0, SEEK_END);
+	const size_t size = ftell (f);
+	rewind (f);
+	unsigned char *data = (unsigned char *) malloc (size);
+	unsigned char *bad = (unsigned char *) malloc (size);
+	CHECK (fread (data, 1, size, f) == size);
+	fclose (f);
+	char *bad_name = TempName (VIDEO_EXTENSION);
+	for (i = 0; i < 300; i++) {
+		memcpy (bad, data, size);
+		if (i % 3 == 0) {
+			// the index is at the end: any truncation loses it
+			WriteFile (bad_name, bad, rand () % size);
+			CHECK (OpenVideo (&video, bad_name) != 0);
+			continue;
+		}
+		int j;
+		for (j = 0; j <= i % 20; j++) {
+			bad[rand () % size] = rand ();
+		}
+		WriteFile (bad_name, bad, size);
+		if (OpenVideo (&video, bad_name) == 0) {
+			for (j = 0; j < 10; j++) {
+				const int err = ReadVideoFrame (&video,
+						rand () % (video.frames + 1), frame);
+				CHECK (err == 0 || err == EBADMSG || err == EINVAL);
+			}
+			CloseVideo (&video);
+		}
+	}
+	CHECK (remove (bad_name) == 0);
+	CHECK (remove (name) == 0);
+	free (bad_name);
+	free (name);
+	free (bad);
+	free (data);
+	FreeMOSAIC (frame);
+
+	DestroyCanvases ();
+	DestroyPages ();
+	endwin ();
+	return TEST_RESULT ();
+}